@@ -0,0 +1,176 @@
+#include "Lexer.h"
+#include "Parser.h"
+#include "Resolver.h"
+#include "Interpreter.h"
+#include "Compiler.h"
+#include "VM.h"
+#include "BuildDatabase.h"
+#include "Executor.h"
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// Synthetic workloads for the lexer, parser, interpreters and the rule scheduler.
+// Usage: BMakeBench [scale], every workload grows linearly with scale (default 1).
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    // Peak resident memory of the process so far, in KiB
+    size_t peakMemory() {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters;
+        if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+            return 0;
+        return counters.PeakWorkingSetSize / 1024;
+#else
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+        return usage.ru_maxrss / 1024;
+#else
+        return usage.ru_maxrss;
+#endif
+#endif
+    }
+
+    template<class F>
+    double seconds(F&& work) {
+        auto start = Clock::now();
+        work();
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    void report(const std::string& name, double count, const char* unit, double time) {
+        std::cout << std::left << std::setw(24) << name << std::right
+                  << std::setw(12) << std::fixed << std::setprecision(1) << time * 1000 << " ms"
+                  << std::setw(14) << std::setprecision(0) << count / time << ' '
+                  << std::left << std::setw(14) << std::string(unit) + "/s" << std::right
+                  << std::setw(10) << peakMemory() << " KiB peak\n";
+    }
+
+    // Functions, loops, conditions, lists and calls, repeated with distinct names
+    std::string generateScript(size_t blocks) {
+        std::string code;
+        for (size_t i = 0; i < blocks; i++)
+        {
+            auto n = std::to_string(i);
+            code += "var count" + n + " = " + n + "\n";
+            code += "var name" + n + " = \"target_" + n + "\"\n";
+            code += "fn step" + n + "(x, y) {\n";
+            code += "    var z = (x + y * 2 - 7) // 3 % 5\n";
+            code += "    if z > 2 && !(x == y) {\n";
+            code += "        return z, [x, y, 1.5, \"s\"]\n";
+            code += "    } else {\n";
+            code += "        z = -z\n";
+            code += "    }\n";
+            code += "    while (z < 10) {\n";
+            code += "        z = z + 1\n";
+            code += "    }\n";
+            code += "    return z\n";
+            code += "}\n";
+            code += "var result" + n + " = step" + n + "(count" + n + ", 3)\n";
+        }
+        return code;
+    }
+
+    void benchFrontend(size_t scale) {
+        auto code = generateScript(2000 * scale);
+        TokenList tokens;
+        double time = seconds([&]() { tokens = Lexer().tokenize(code); });
+        report("lexer", tokens.tokens.size(), "tokens", time);
+
+        auto arena = Arena(tokens.tokens.size() * 32);
+        auto parser = Parser(arena);
+        time = seconds([&]() { parser.getAST(tokens); });
+        report("parser", parser.nodeCount(), "nodes", time);
+    }
+
+    std::string loopScript(size_t iterations) {
+        return "var a = " + std::to_string(iterations) + "\n"
+               "var b = 0\n"
+               "while (a > 0) {\n"
+               "    a = a - 1\n"
+               "    b = b + 2\n"
+               "    if (b > 100) {\n"
+               "        b = b - b % 7\n"
+               "    }\n"
+               "}\n";
+    }
+
+    void benchInterpreters(size_t scale) {
+        size_t iterations = 1000000 * scale;
+        auto code = loopScript(iterations);
+        auto tokens = Lexer().tokenize(code);
+        auto arena = Arena();
+        auto ast = Parser(arena).getAST(tokens);
+        Resolver().resolve(ast);
+
+        Interpreter tree_walker;
+        tree_walker.verbose = false;
+        std::vector<Value> args;
+        double time = seconds([&]() { tree_walker.run(ast, "", args); });
+        report("tree-walk interpreter", iterations, "iterations", time);
+
+        // The resolver annotates the AST in place, so the compiler gets a fresh one
+        auto compile_arena = Arena();
+        auto program = Compiler().compile(Parser(compile_arena).getAST(tokens));
+        Interpreter interpreter;
+        interpreter.verbose = false;
+        auto vm = VM(interpreter);
+        time = seconds([&]() { vm.run(program.view()); });
+        report("bytecode vm", iterations, "iterations", time);
+    }
+
+    // Layers of rules where every rule reads two outputs of the layer above. All outputs exist and are
+    // recorded beforehand, so nothing is run and the time goes to linking, prioritizing, scheduling and checks.
+    void benchScheduler(size_t scale) {
+        const size_t width = 100, depth = 50 * scale;
+        auto directory = std::filesystem::temp_directory_path() / "bmake_bench";
+        std::filesystem::remove_all(directory);
+        std::filesystem::create_directories(directory);
+
+        BuildGraph graph;
+        graph.directory = directory;
+        auto output = [](size_t layer, size_t i) { return "r" + std::to_string(layer) + "_" + std::to_string(i); };
+        for (size_t layer = 0; layer < depth; layer++)
+        {
+            for (size_t i = 0; i < width; i++)
+            {
+                std::vector<std::string> inputs;
+                if (layer != 0)
+                    inputs = { output(layer - 1, i), output(layer - 1, (i + 1) % width) };
+                auto name = output(layer, i);
+                std::ofstream(directory / name).put('x');
+                graph.addRule(std::move(inputs), { name }, "true " + name);
+            }
+        }
+
+        BuildDatabase database((directory / "bench_db").string());
+        graph.link();
+        for (size_t i = 0; i < graph.size(); i++)
+            database.record(graph.rule(i), 1000);
+
+        auto executor = Executor(std::max(1u, std::thread::hardware_concurrency()), &database);
+        double time = seconds([&]() { executor.run(graph); });
+        report("scheduler", graph.size(), "rules", time);
+        std::filesystem::remove_all(directory);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    size_t scale = argc > 1 ? std::max(1, std::atoi(argv[1])) : 1;
+    benchFrontend(scale);
+    benchInterpreters(scale);
+    benchScheduler(scale);
+}
@@ -1,8 +1,9 @@
 #pragma once
 #include "token.h"
-#include <memory>
+#include <memory_resource>
+#include <string_view>
 #include <vector>
-#include <list>
+#include <cstdint>
 
 
 // Basic Nodes
@@ -33,6 +34,9 @@ enum class ExprType {
     And,
     Mod,
     Neg,
+    List,
+    IntBinaryOp, // quickened BinaryOpExpr, see BinaryOpExpr::op
+    FloatBinaryOp,
     Last,
 };
 
@@ -46,12 +50,16 @@ enum class StmtType {
     DoWhile,
     For,
     Block,
+    Function,
+    Return,
     Last,
 };
 
 struct Node
 {
     enum class NodeType { Expr, Stmt } node_type;
+    uint32_t line = 0;
+    uint32_t column = 0;
 };
 
 struct Expr : Node
@@ -82,9 +90,11 @@ struct Stmt : Node
 // Expressions
 struct IdentifierExpr : Expr
 {
-    std::string id;
+    std::string_view id;
+    uint32_t depth = 0;
+    uint32_t slot = 0;
 
-    IdentifierExpr(std::string value) : Expr() {
+    IdentifierExpr(std::string_view value) : Expr() {
         expr_type = ExprType::Identifier;
         this->id = value;
         left = true;
@@ -103,9 +113,9 @@ struct BoolLiteralExpr : Expr
 
 struct StringLiteralExpr : Expr
 {
-    std::string value;
+    std::string_view value;
 
-    StringLiteralExpr(std::string value) : Expr() {
+    StringLiteralExpr(std::string_view value) : Expr() {
         expr_type = ExprType::StringLiteral;
         this->value = value;
     }
@@ -133,44 +143,67 @@ struct FloatLiteralExpr : Expr
 
 struct UnaryOpExpr : Expr
 {
-    std::unique_ptr<Expr> expr;
+    Expr* expr;
 
-    UnaryOpExpr(std::unique_ptr<Expr> expr, ExprType type) : Expr() {
+    UnaryOpExpr(Expr* expr, ExprType type) : Expr() {
         this->expr_type = type;
-        this->expr = std::move(expr);
+        this->expr = expr;
     }
 };
 
 struct BinaryOpExpr : Expr
 {
-    std::unique_ptr<Expr> left_expr;
-    std::unique_ptr<Expr> right_expr;
-
-    BinaryOpExpr(std::unique_ptr<Expr> left_expr, std::unique_ptr<Expr> right_expr, ExprType type) : Expr() {
+    Expr* left_expr;
+    Expr* right_expr;
+    // The operator itself. The tree walker may rewrite expr_type into an int or float
+    // specialized variant after the first evaluation and back to op when its type guard fails.
+    ExprType op;
+    bool quickenable = true;
+
+    BinaryOpExpr(Expr* left_expr, Expr* right_expr, ExprType type) : Expr() {
         expr_type = type;
-        this->left_expr = std::move(left_expr);
-        this->right_expr = std::move(right_expr);
+        op = type;
+        this->left_expr = left_expr;
+        this->right_expr = right_expr;
     }
 };
 
+struct KeywordArg
+{
+    std::string_view name;
+    Expr* value;
+};
+
 struct FnCallExpr : Expr
 {
-    std::unique_ptr<Expr> id_expr;
-    std::list<std::unique_ptr<Expr>> args;
+    Expr* id_expr;
+    std::pmr::vector<Expr*> args;
+    std::pmr::vector<KeywordArg> keywords;
 
-    FnCallExpr(std::unique_ptr<Expr> id_expr) : Expr() {
+    FnCallExpr(Expr* id_expr, std::pmr::memory_resource* memory) : Expr(), args(memory), keywords(memory) {
         expr_type = ExprType::FnCall;
-        this->id_expr = std::move(id_expr);
+        this->id_expr = id_expr;
     }
 
-    FnCallExpr(std::unique_ptr<Expr> id_expr, std::list<std::unique_ptr<Expr>>& args) : Expr() {
-        expr_type = ExprType::FnCall;
-        this->id_expr = std::move(id_expr);
-        this->args = std::move(args);
+    void add(Expr* arg) {
+        args.push_back(arg);
     }
 
-    void add(std::unique_ptr<Expr> arg) {
-        args.push_back(std::move(arg));
+    void addKeyword(std::string_view name, Expr* value) {
+        keywords.push_back({ name, value });
+    }
+};
+
+struct ListExpr : Expr
+{
+    std::pmr::vector<Expr*> items;
+
+    ListExpr(std::pmr::memory_resource* memory) : Expr(), items(memory) {
+        expr_type = ExprType::List;
+    }
+
+    void add(Expr* item) {
+        items.push_back(item);
     }
 };
 
@@ -178,35 +211,35 @@ struct FnCallExpr : Expr
 // Statements
 struct ExpressionStmt : Stmt
 {
-    std::unique_ptr<Expr> expr;
+    Expr* expr;
 
-    ExpressionStmt(std::unique_ptr<Expr> expr) : Stmt() {
+    ExpressionStmt(Expr* expr) : Stmt() {
         stmt_type = StmtType::Expression;
-        this->expr = std::move(expr);
+        this->expr = expr;
     }
 };
 
 struct DeclarationStmt : Stmt
 {
-    std::unique_ptr<IdentifierExpr> id;
-    std::unique_ptr<Expr> right;
+    IdentifierExpr* id;
+    Expr* right;
 
-    DeclarationStmt(std::unique_ptr<IdentifierExpr> id, std::unique_ptr<Expr> right) : Stmt() {
+    DeclarationStmt(IdentifierExpr* id, Expr* right) : Stmt() {
         stmt_type = StmtType::Declaration;
-        this->id = std::move(id);
-        this->right = std::move(right);
+        this->id = id;
+        this->right = right;
     }
 };
 
 struct AssignmentStmt : Stmt
 {
-    std::unique_ptr<Expr> left;
-    std::unique_ptr<Expr> right;
+    Expr* left;
+    Expr* right;
 
-    AssignmentStmt(std::unique_ptr<Expr> left, std::unique_ptr<Expr> right) : Stmt() {
+    AssignmentStmt(Expr* left, Expr* right) : Stmt() {
         stmt_type = StmtType::Assignment;
-        this->left = std::move(left);
-        this->right = std::move(right);
+        this->left = left;
+        this->right = right;
     }
 };
 
@@ -218,72 +251,91 @@ struct NoneStmt : Stmt {
 
 struct BlockStmt : Stmt
 {
-    std::vector<std::unique_ptr<Stmt>> stmts;
+    std::pmr::vector<Stmt*> stmts;
+    std::pmr::vector<std::string_view> names;
 
-    BlockStmt() : Stmt() {
+    BlockStmt(std::pmr::memory_resource* memory) : Stmt(), stmts(memory), names(memory) {
         stmt_type = StmtType::Block;
     }
 
-    BlockStmt(std::vector<std::unique_ptr<Stmt>>& stmts) : Stmt() {
-        stmt_type = StmtType::Block;
-        this->stmts = std::move(stmts);
-    }
-
-    void add(std::unique_ptr<Stmt> stmt) {
-        stmts.push_back(std::move(stmt));
+    void add(Stmt* stmt) {
+        stmts.push_back(stmt);
     }
 };
 
 struct IfStmt : Stmt
 {
-    std::unique_ptr<Expr> cond;
-    std::unique_ptr<BlockStmt> action;
-    std::unique_ptr<BlockStmt> else_action;
+    Expr* cond;
+    BlockStmt* action;
+    BlockStmt* else_action;
 
-    IfStmt(std::unique_ptr<Expr> cond, std::unique_ptr<BlockStmt> action, std::unique_ptr<BlockStmt> else_action) : Stmt() {
+    IfStmt(Expr* cond, BlockStmt* action, BlockStmt* else_action) : Stmt() {
         stmt_type = StmtType::If;
-        this->cond = std::move(cond);
-        this->action = std::move(action);
-        this->else_action = std::move(else_action);
+        this->cond = cond;
+        this->action = action;
+        this->else_action = else_action;
     }
 };
 
 struct WhileStmt : Stmt
 {
-    std::unique_ptr<Expr> cond;
-    std::unique_ptr<BlockStmt> action;
+    Expr* cond;
+    BlockStmt* action;
 
-    WhileStmt(std::unique_ptr<Expr> cond, std::unique_ptr<BlockStmt> action) : Stmt() {
+    WhileStmt(Expr* cond, BlockStmt* action) : Stmt() {
         stmt_type = StmtType::While;
-        this->cond = std::move(cond);
-        this->action = std::move(action);
+        this->cond = cond;
+        this->action = action;
     }
 };
 
 struct DoWhileStmt : Stmt
 {
-    std::unique_ptr<Expr> cond;
-    std::unique_ptr<BlockStmt> action;
+    Expr* cond;
+    BlockStmt* action;
 
-    DoWhileStmt(std::unique_ptr<Expr> cond, std::unique_ptr<BlockStmt> action) : Stmt() {
+    DoWhileStmt(Expr* cond, BlockStmt* action) : Stmt() {
         stmt_type = StmtType::DoWhile;
-        this->cond = std::move(cond);
-        this->action = std::move(action);
+        this->cond = cond;
+        this->action = action;
     }
 };
 
 struct ForStmt : Stmt
 {
-    std::unique_ptr<Stmt> init;
-    std::unique_ptr<Expr> cond;
-    std::unique_ptr<Stmt> post;
-    std::unique_ptr<Stmt> action;
+    Stmt* init;
+    Expr* cond;
+    Stmt* post;
+    Stmt* action;
 
-    ForStmt(std::unique_ptr<Stmt> init, std::unique_ptr<Expr> cond, std::unique_ptr<Stmt> post, std::unique_ptr<Stmt> action) : Stmt() {
+    ForStmt(Stmt* init, Expr* cond, Stmt* post, Stmt* action) : Stmt() {
         stmt_type = StmtType::For;
-        this->cond = std::move(cond);
-        this->action = std::move(action);
-        this->init = std::move(init);
-        this->post = std::move(post);
+        this->cond = cond;
+        this->action = action;
+        this->init = init;
+        this->post = post;
+    }
+};
+
+struct FunctionStmt : Stmt
+{
+    std::string_view name;
+    std::pmr::vector<std::string_view> params;
+    BlockStmt* body;
+
+    FunctionStmt(std::string_view name, BlockStmt* body, std::pmr::memory_resource* memory) : Stmt(), params(memory) {
+        stmt_type = StmtType::Function;
+        this->name = name;
+        this->body = body;
+    }
+};
+
+struct ReturnStmt : Stmt
+{
+    Expr* value; // nullptr for a bare return
+
+    ReturnStmt(Expr* value) : Stmt() {
+        stmt_type = StmtType::Return;
+        this->value = value;
     }
 };
\ No newline at end of file
@@ -0,0 +1,33 @@
+#pragma once
+#include <memory_resource>
+#include <string_view>
+#include <cstring>
+#include <utility>
+
+// Bump allocator for AST nodes. Nodes are never destroyed one by one,
+// all memory is released at once together with the arena.
+class Arena {
+    std::pmr::monotonic_buffer_resource resource;
+public:
+    explicit Arena(size_t initial_size = 64 * 1024) : resource(initial_size) { }
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    template<class T, class... Args>
+    T* make(Args&&... args) {
+        void* memory = resource.allocate(sizeof(T), alignof(T));
+        return new (memory) T(std::forward<Args>(args)...);
+    }
+
+    std::string_view copy(std::string_view str) {
+        if (str.empty())
+            return { };
+        auto memory = static_cast<char*>(resource.allocate(str.size(), 1));
+        std::memcpy(memory, str.data(), str.size());
+        return { memory, str.size() };
+    }
+
+    std::pmr::memory_resource* memory() {
+        return &resource;
+    }
+};
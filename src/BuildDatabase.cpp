@@ -0,0 +1,250 @@
+#include "BuildDatabase.h"
+#include "Hash.h"
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/filesystem/fstream.hpp>
+#include <algorithm>
+#include <iostream>
+
+namespace {
+    const char database_magic[4] = { 'B', 'M', 'D', 'B' };
+    const uint32_t database_version = 3;
+    const uint64_t unknown_duration = UINT64_MAX;
+
+    template<class T>
+    void write(std::ostream& out, T value) {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void write(std::ostream& out, const std::string& str) {
+        write<uint32_t>(out, str.size());
+        out.write(str.data(), str.size());
+    }
+
+    template<class T>
+    T read(std::istream& in) {
+        T value{};
+        in.read(reinterpret_cast<char*>(&value), sizeof(T));
+        return value;
+    }
+
+    std::string readString(std::istream& in) {
+        auto size = read<uint32_t>(in);
+        std::string str(size, '\0');
+        in.read(str.data(), size);
+        return str;
+    }
+}
+
+std::optional<uint64_t> BuildDatabase::hashFile(const boost::filesystem::path& file) {
+    boost::system::error_code error;
+    auto size = boost::filesystem::file_size(file, error);
+    if (error)
+        return std::nullopt;
+    if (size == 0)
+        return hashBytes(nullptr, 0);
+    boost::iostreams::mapped_file_source source;
+    try {
+        source.open(file);
+    }
+    catch (std::exception&) {
+        return std::nullopt;
+    }
+    return hashBytes(source.data(), source.size());
+}
+
+std::string BuildDatabase::key(const Rule& rule) {
+    if (rule.outputs.empty())
+        return rule.command;
+    std::string key;
+    for (auto& output : rule.outputs)
+        key += filePath(rule, output) + '\n';
+    return key;
+}
+
+std::string BuildDatabase::filePath(const Rule& rule, const std::string& file) {
+    return (boost::filesystem::path(rule.directory.string()) / file).lexically_normal().string();
+}
+
+std::optional<std::vector<BuildDatabase::FileHash>> BuildDatabase::hashFiles(const Rule& rule, const std::vector<std::string>& files) {
+    std::vector<FileHash> hashes;
+    for (auto& file : files)
+    {
+        auto path = filePath(rule, file);
+        auto stat = stats.stat(path);
+        auto hash = stats.hash(path);
+        if (!hash)
+            return std::nullopt;
+        hashes.push_back({ file, *hash, stat });
+    }
+    return hashes;
+}
+
+// Compares files against the stored hashes, hashing only those whose stat changed.
+// Stored stats are refreshed for files that were touched but kept their content.
+bool BuildDatabase::matches(const Rule& rule, const std::vector<std::string>& files, std::vector<FileHash>& stored) {
+    if (files.size() != stored.size())
+        return false;
+    for (size_t i = 0; i < files.size(); i++)
+    {
+        if (files[i] != stored[i].path)
+            return false;
+        auto path = filePath(rule, files[i]);
+        auto stat = stats.stat(path);
+        if (!stat.exists)
+            return false;
+        if (stat == stored[i].stat)
+            continue;
+        auto hash = stats.hash(path);
+        if (!hash || *hash != stored[i].hash)
+            return false;
+        stored[i].stat = stat;
+    }
+    return true;
+}
+
+bool BuildDatabase::upToDate(const Rule& rule) {
+    Record stored;
+    {
+        std::lock_guard lock(mutex);
+        auto it = records.find(key(rule));
+        if (it == records.end())
+            return false;
+        stored = it->second;
+    }
+    if (stored.command != rule.command)
+        return false;
+    if (!matches(rule, rule.inputs, stored.inputs) || !matches(rule, rule.outputs, stored.outputs))
+        return false;
+    std::lock_guard lock(mutex);
+    records[key(rule)] = std::move(stored);
+    return true;
+}
+
+std::optional<uint64_t> BuildDatabase::actionHash(const Rule& rule) {
+    auto mix = [](uint64_t value, uint64_t hash) { return hashBytes(reinterpret_cast<const char*>(&value), sizeof(value), hash); };
+    uint64_t hash = hashString(rule.command);
+    for (auto& output : rule.outputs)
+        hash = hashString(output, mix(output.size(), hash));
+    for (auto& input : rule.inputs)
+    {
+        auto content = stats.hash(filePath(rule, input));
+        if (!content)
+            return std::nullopt;
+        hash = mix(*content, hashString(input, mix(input.size(), hash)));
+    }
+    return hash;
+}
+
+void BuildDatabase::scan(BuildGraph& graph, ThreadPool& pool) {
+    std::vector<std::string> paths;
+    for (auto& rule : graph.getRules())
+    {
+        for (auto& file : rule.inputs)
+            paths.push_back(filePath(rule, file));
+        for (auto& file : rule.outputs)
+            paths.push_back(filePath(rule, file));
+    }
+    std::sort(paths.begin(), paths.end());
+    paths.erase(std::unique(paths.begin(), paths.end()), paths.end());
+    stats.scan(paths, pool);
+}
+
+void BuildDatabase::record(const Rule& rule, std::optional<uint64_t> duration) {
+    // The command has just rewritten its outputs
+    for (auto& output : rule.outputs)
+        stats.invalidate(filePath(rule, output));
+    auto inputs = hashFiles(rule, rule.inputs);
+    auto outputs = hashFiles(rule, rule.outputs);
+    std::lock_guard lock(mutex);
+    auto record_key = key(rule);
+    if (!inputs || !outputs)
+    {
+        records.erase(record_key);
+        return;
+    }
+    // Restored before the command ever ran here, the duration stays unknown rather than counting as instant
+    auto it = records.find(record_key);
+    uint64_t time = duration ? *duration : it != records.end() ? it->second.duration : unknown_duration;
+    records[record_key] = { rule.command, std::move(*inputs), std::move(*outputs), time };
+}
+
+std::optional<uint64_t> BuildDatabase::duration(const Rule& rule) {
+    std::lock_guard lock(mutex);
+    auto it = records.find(key(rule));
+    if (it == records.end() || it->second.duration == unknown_duration)
+        return std::nullopt;
+    return it->second.duration;
+}
+
+void BuildDatabase::load() {
+    records.clear();
+    boost::filesystem::ifstream in(path, std::ios::binary);
+    if (!in)
+        return;
+    char magic[4];
+    in.read(magic, 4);
+    if (!in || !std::equal(magic, magic + 4, database_magic) || read<uint32_t>(in) != database_version)
+        return;
+    auto count = read<uint32_t>(in);
+    for (uint32_t i = 0; i < count && in; i++)
+    {
+        auto name = readString(in);
+        Record record;
+        record.command = readString(in);
+        for (auto files : { &record.inputs, &record.outputs })
+        {
+            auto size = read<uint32_t>(in);
+            for (uint32_t k = 0; k < size && in; k++)
+            {
+                FileHash file;
+                file.path = readString(in);
+                file.hash = read<uint64_t>(in);
+                file.stat.size = read<uint64_t>(in);
+                file.stat.mtime = read<int64_t>(in);
+                file.stat.inode = read<uint64_t>(in);
+                file.stat.exists = true;
+                files->push_back(std::move(file));
+            }
+        }
+        record.duration = read<uint64_t>(in);
+        if (in)
+            records[name] = std::move(record);
+    }
+}
+
+void BuildDatabase::save() {
+    std::lock_guard lock(mutex);
+    auto temp = path;
+    temp += ".tmp";
+    {
+        boost::filesystem::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        if (!out)
+        {
+            std::cout << "Can't write build database " << path.string() << '\n';
+            return;
+        }
+        out.write(database_magic, 4);
+        write<uint32_t>(out, database_version);
+        write<uint32_t>(out, records.size());
+        for (auto& [name, record] : records)
+        {
+            write(out, name);
+            write(out, record.command);
+            for (auto files : { &record.inputs, &record.outputs })
+            {
+                write<uint32_t>(out, files->size());
+                for (auto& file : *files)
+                {
+                    write(out, file.path);
+                    write<uint64_t>(out, file.hash);
+                    write<uint64_t>(out, file.stat.size);
+                    write<int64_t>(out, file.stat.mtime);
+                    write<uint64_t>(out, file.stat.inode);
+                }
+            }
+            write<uint64_t>(out, record.duration);
+        }
+    }
+    boost::system::error_code error;
+    boost::filesystem::rename(temp, path, error);
+}
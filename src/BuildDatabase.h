@@ -0,0 +1,54 @@
+#pragma once
+#include "BuildGraph.h"
+#include "StatCache.h"
+#include "ThreadPool.h"
+#include <boost/filesystem.hpp>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class BuildDatabase {
+    struct FileHash {
+        std::string path;
+        uint64_t hash;
+        FileStat stat; // when it still matches, the file isn't hashed again
+    };
+
+    struct Record {
+        std::string command;
+        std::vector<FileHash> inputs;
+        std::vector<FileHash> outputs;
+        uint64_t duration; // microseconds the command took last time, UINT64_MAX while unknown
+    };
+
+    boost::filesystem::path path;
+    std::unordered_map<std::string, Record> records;
+    std::mutex mutex;
+    StatCache stats;
+
+    std::string key(const Rule& rule);
+    std::optional<std::vector<FileHash>> hashFiles(const Rule& rule, const std::vector<std::string>& files);
+    bool matches(const Rule& rule, const std::vector<std::string>& files, std::vector<FileHash>& stored);
+public:
+    explicit BuildDatabase(boost::filesystem::path path) : path(std::move(path)) { }
+
+    void load();
+    // Stats the inputs and outputs of every rule up front
+    void scan(BuildGraph& graph, ThreadPool& pool);
+    // Drops the cached stat and hash of a file that changed, returns false if it looks the same
+    bool refresh(const std::string& path) { return stats.refresh(path); }
+    void save();
+    bool upToDate(const Rule& rule);
+    // Without a duration, e.g. for outputs restored from a cache, the previously recorded one is kept
+    void record(const Rule& rule, std::optional<uint64_t> duration);
+    std::optional<uint64_t> duration(const Rule& rule);
+    // Hash of the command, output names and input contents, nullopt when an input is missing
+    std::optional<uint64_t> actionHash(const Rule& rule);
+
+    static std::optional<uint64_t> hashFile(const boost::filesystem::path& file);
+    // Normalized path of a rule input or output, as used for keys and the stat cache
+    static std::string filePath(const Rule& rule, const std::string& file);
+};
@@ -0,0 +1,98 @@
+#include "BuildGraph.h"
+#include <cctype>
+#include <algorithm>
+
+std::string BuildGraph::normalize(const std::filesystem::path& dir, const std::string& file) {
+    return (dir / file).lexically_normal().string();
+}
+
+std::string BuildGraph::expandCommand(const std::string& command, const std::vector<std::string>& inputs,
+                                      const std::vector<std::string>& outputs) {
+    std::string result;
+    for (size_t i = 0; i < command.size(); i++)
+    {
+        char ch = command[i];
+        if ((ch == '$' || ch == '%') && i + 1 < command.size() && isdigit(command[i + 1]))
+        {
+            size_t n = 0;
+            while (i + 1 < command.size() && isdigit(command[i + 1]))
+                n = n * 10 + (command[++i] - '0');
+            auto& files = ch == '$' ? inputs : outputs;
+            if (n >= files.size())
+                throw std::exception("Rule command refers to a missing file");
+            result += files[n];
+            continue;
+        }
+        result += ch;
+    }
+    return result;
+}
+
+size_t BuildGraph::addRule(std::vector<std::string> inputs, std::vector<std::string> outputs, const std::string& command) {
+    Rule rule;
+    rule.command = expandCommand(command, inputs, outputs);
+    rule.directory = directory;
+    rule.inputs = std::move(inputs);
+    rule.outputs = std::move(outputs);
+    rules.push_back(std::move(rule));
+    return rules.size() - 1;
+}
+
+void BuildGraph::link() {
+    producers.clear();
+    for (size_t i = 0; i < rules.size(); i++)
+    {
+        rules[i].deps.clear();
+        rules[i].dependents.clear();
+        for (auto& output : rules[i].outputs)
+        {
+            auto [_, inserted] = producers.emplace(normalize(rules[i].directory, output), i);
+            if (!inserted)
+                throw std::exception("Output is produced by more than one rule");
+        }
+    }
+    for (size_t i = 0; i < rules.size(); i++)
+    {
+        for (auto& input : rules[i].inputs)
+        {
+            auto producer = producers.find(normalize(rules[i].directory, input));
+            if (producer == producers.end() || producer->second == i)
+                continue;
+            if (std::find(rules[i].deps.begin(), rules[i].deps.end(), producer->second) != rules[i].deps.end())
+                continue;
+            rules[i].deps.push_back(producer->second);
+            rules[producer->second].dependents.push_back(i);
+        }
+    }
+
+    std::vector<size_t> pending(rules.size());
+    std::vector<size_t> ready;
+    for (size_t i = 0; i < rules.size(); i++)
+    {
+        pending[i] = rules[i].deps.size();
+        if (pending[i] == 0)
+            ready.push_back(i);
+    }
+    size_t visited = 0;
+    while (!ready.empty())
+    {
+        size_t i = ready.back();
+        ready.pop_back();
+        visited++;
+        for (auto dependent : rules[i].dependents)
+            if (--pending[dependent] == 0)
+                ready.push_back(dependent);
+    }
+    if (visited != rules.size())
+        throw std::exception("Build graph contains a cycle");
+}
+
+void BuildGraph::append(BuildGraph& other) {
+    for (auto& rule : other.rules)
+        rules.push_back(std::move(rule));
+    other.rules.clear();
+}
+
+void BuildGraph::append(const BuildGraph& other) {
+    rules.insert(rules.end(), other.rules.begin(), other.rules.end());
+}
\ No newline at end of file
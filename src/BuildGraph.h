@@ -0,0 +1,35 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <filesystem>
+
+struct Rule
+{
+    std::vector<std::string> inputs;
+    std::vector<std::string> outputs;
+    std::string command;
+    std::filesystem::path directory;
+    std::vector<size_t> deps;
+    std::vector<size_t> dependents;
+};
+
+class BuildGraph {
+    std::vector<Rule> rules;
+    std::unordered_map<std::string, size_t> producers;
+
+    std::string expandCommand(const std::string& command, const std::vector<std::string>& inputs,
+                              const std::vector<std::string>& outputs);
+public:
+    std::filesystem::path directory = std::filesystem::current_path();
+
+    size_t addRule(std::vector<std::string> inputs, std::vector<std::string> outputs, const std::string& command);
+    void link();
+    void append(BuildGraph& other);
+    void append(const BuildGraph& other);
+    std::string normalize(const std::filesystem::path& dir, const std::string& file);
+
+    size_t size() { return rules.size(); }
+    Rule& rule(size_t i) { return rules[i]; }
+    std::vector<Rule>& getRules() { return rules; }
+};
@@ -0,0 +1,136 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Bump whenever the instruction set or the layout of the structures below changes,
+// cached programs with another version are recompiled
+const uint32_t bytecode_version = 2;
+
+enum class OpCode : uint8_t {
+    LoadConst, // a = constants[bx]
+    Move, // a = b
+    LoadGlobal, // a = globals[bx]
+    StoreGlobal, // globals[bx] = a
+    Add, // a = b + c
+    Sub,
+    Mul,
+    Div,
+    IntDiv,
+    Mod,
+    Eq,
+    NotEq,
+    Greater,
+    Less,
+    GreaterEq,
+    LessEq,
+    And,
+    Or,
+    Neg, // a = -b
+    Not,
+    ToBool,
+    ToString,
+    ToInt,
+    ToFloat,
+    MakeList, // a = [b, ..., b + c - 1]
+    Call, // a = functions[b](a + 1, ..., a + c), followed by d (name, value) keyword pairs
+    CallProc, // a = procedures[b](a + 1, ..., a + c), the callee's registers start at a + 1
+    Return, // return a to the caller
+    Jump, // goto bx
+    JumpIfFalse, // if (!a) goto bx
+    JumpIfTrue, // if (a) goto bx
+    Halt,
+    Last,
+};
+
+struct Instr {
+    OpCode op;
+    uint8_t d = 0;
+    uint16_t a = 0;
+    uint16_t b = 0;
+    uint16_t c = 0;
+
+    uint32_t bx() const {
+        return b | (uint32_t)c << 16;
+    }
+
+    static Instr ABC(OpCode op, uint16_t a, uint16_t b = 0, uint16_t c = 0) {
+        return { op, 0, a, b, c };
+    }
+
+    static Instr ABx(OpCode op, uint16_t a, uint32_t bx) {
+        return { op, 0, a, (uint16_t)(bx & 0xFFFF), (uint16_t)(bx >> 16) };
+    }
+};
+
+enum class ConstantType : uint8_t {
+    Int, Float, Bool, String,
+};
+
+struct StringRef {
+    uint32_t offset;
+    uint32_t length;
+};
+
+struct Constant {
+    ConstantType type;
+    union {
+        int int_val;
+        float float_val;
+        bool bool_val;
+        StringRef str;
+    };
+};
+
+struct Symbol {
+    StringRef name;
+    uint16_t reg;
+};
+
+// Function defined in the script
+struct Procedure {
+    StringRef name;
+    uint32_t entry;
+    uint16_t params;
+    uint16_t registers;
+};
+
+// Non-owning view of a compiled program, either over a Program or over a cached file mapping
+struct ProgramView {
+    std::span<const Instr> code;
+    std::span<const Constant> constants;
+    std::span<const StringRef> functions;
+    std::span<const Symbol> globals;
+    std::span<const Procedure> procedures;
+    std::string_view strings;
+    uint16_t registers = 0;
+
+    std::string_view string(StringRef ref) const {
+        return strings.substr(ref.offset, ref.length);
+    }
+};
+
+struct Program {
+    std::vector<Instr> code;
+    std::vector<Constant> constants;
+    std::vector<StringRef> functions;
+    std::vector<Symbol> globals;
+    std::vector<Procedure> procedures;
+    std::string strings;
+    uint16_t registers = 0;
+
+    std::string_view string(StringRef ref) const {
+        return std::string_view(strings).substr(ref.offset, ref.length);
+    }
+
+    ProgramView view() const {
+        return { code, constants, functions, globals, procedures, strings, registers };
+    }
+};
+
+static_assert(std::is_trivially_copyable_v<Instr> && std::is_trivially_copyable_v<Constant>
+        && std::is_trivially_copyable_v<StringRef> && std::is_trivially_copyable_v<Symbol>
+        && std::is_trivially_copyable_v<Procedure>);
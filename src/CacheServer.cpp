@@ -0,0 +1,103 @@
+#include "CacheServer.h"
+#include "RemoteCache.h"
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+namespace http = boost::beast::http;
+using boost::asio::ip::tcp;
+
+namespace {
+    // Key from a target ending in /cas/<16 hex digits>, empty for anything else so no other path can be reached
+    std::string entryKey(std::string_view target) {
+        auto position = target.rfind("/cas/");
+        if (position == std::string_view::npos)
+            return { };
+        auto key = target.substr(position + 5);
+        if (key.size() != 16 || key.find_first_not_of("0123456789abcdef") != std::string_view::npos)
+            return { };
+        return std::string(key);
+    }
+
+    http::response<http::string_body> handle(const std::filesystem::path& directory,
+                                             const http::request<http::string_body>& request) {
+        http::response<http::string_body> response(http::status::ok, request.version());
+        response.keep_alive(request.keep_alive());
+        auto target = request.target();
+        auto key = entryKey({ target.data(), target.size() });
+        if (key.empty())
+            response.result(http::status::not_found);
+        else if (request.method() == http::verb::get)
+        {
+            std::ifstream in(directory / key, std::ios::binary);
+            if (in)
+            {
+                std::ostringstream body;
+                body << in.rdbuf();
+                response.body() = body.str();
+                response.set(http::field::content_type, "application/octet-stream");
+            }
+            else
+                response.result(http::status::not_found);
+        }
+        else if (request.method() == http::verb::put)
+        {
+            // Written under a private name and renamed, concurrent readers see the old entry or the new one
+            std::ostringstream name;
+            name << key << '.' << std::this_thread::get_id() << ".tmp";
+            auto temp = directory / name.str();
+            {
+                std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+                out.write(request.body().data(), request.body().size());
+            }
+            std::error_code error;
+            std::filesystem::rename(temp, directory / key, error);
+            response.result(error ? http::status::internal_server_error : http::status::created);
+        }
+        else
+            response.result(http::status::method_not_allowed);
+        response.prepare_payload();
+        return response;
+    }
+
+    void session(const std::filesystem::path& directory, tcp::socket socket) {
+        boost::beast::flat_buffer buffer;
+        boost::system::error_code error;
+        while (true)
+        {
+            http::request_parser<http::string_body> parser;
+            parser.body_limit(RemoteCache::max_body);
+            http::read(socket, buffer, parser, error);
+            if (error)
+                break;
+            auto response = handle(directory, parser.get());
+            http::write(socket, response, error);
+            if (error || !response.keep_alive())
+                break;
+        }
+        socket.shutdown(tcp::socket::shutdown_send, error);
+    }
+}
+
+int CacheServer::serve(unsigned short port) {
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error)
+    {
+        std::cout << "Can't create " << directory.string() << '\n';
+        return 1;
+    }
+    boost::asio::io_context context;
+    tcp::acceptor acceptor(context, { boost::asio::ip::address_v4::loopback(), port });
+    std::cout << "Serving " << directory.string() << " on http://127.0.0.1:" << acceptor.local_endpoint().port() << std::endl;
+    while (true)
+    {
+        tcp::socket socket(context);
+        acceptor.accept(socket);
+        std::thread(session, directory, std::move(socket)).detach();
+    }
+}
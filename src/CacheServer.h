@@ -0,0 +1,13 @@
+#pragma once
+#include <filesystem>
+
+// Reference server for --remote-cache, meant for testing and small teams: entries are files in a directory,
+// every connection gets its own thread and pipelined requests are answered in order.
+class CacheServer {
+    std::filesystem::path directory;
+public:
+    explicit CacheServer(std::filesystem::path directory) : directory(std::move(directory)) { }
+
+    // Listens on the loopback interface until the process is stopped
+    int serve(unsigned short port);
+};
@@ -0,0 +1,388 @@
+#include "Compiler.h"
+#include <bit>
+
+namespace {
+    OpCode binaryOpCode(ExprType type) {
+        switch (type) {
+            case ExprType::Add: return OpCode::Add;
+            case ExprType::Sub: return OpCode::Sub;
+            case ExprType::Mul: return OpCode::Mul;
+            case ExprType::Div: return OpCode::Div;
+            case ExprType::IntDiv: return OpCode::IntDiv;
+            case ExprType::Mod: return OpCode::Mod;
+            case ExprType::Eq: return OpCode::Eq;
+            case ExprType::NotEq: return OpCode::NotEq;
+            case ExprType::Greater: return OpCode::Greater;
+            case ExprType::Less: return OpCode::Less;
+            case ExprType::GreaterEq: return OpCode::GreaterEq;
+            case ExprType::LessEq: return OpCode::LessEq;
+            case ExprType::And: return OpCode::And;
+            case ExprType::Or: return OpCode::Or;
+            default: return OpCode::Last;
+        }
+    }
+
+    OpCode unaryOpCode(ExprType type) {
+        switch (type) {
+            case ExprType::Neg: return OpCode::Neg;
+            case ExprType::Not: return OpCode::Not;
+            case ExprType::ToBool: return OpCode::ToBool;
+            case ExprType::ToString: return OpCode::ToString;
+            case ExprType::ToInt: return OpCode::ToInt;
+            case ExprType::ToFloat: return OpCode::ToFloat;
+            default: return OpCode::Last;
+        }
+    }
+}
+
+Program Compiler::compile(Stmt* ast) {
+    program = Program();
+    scopes.clear();
+    string_constants.clear();
+    number_constants.clear();
+    function_ids.clear();
+    procedure_ids.clear();
+    function_scope = 0;
+    next_reg = 0;
+    frame_size = 0;
+
+    auto root = dynamic_cast<BlockStmt*>(ast);
+    if (root == nullptr)
+        throw std::exception("Expected block at the top level");
+    block(root, true);
+    emit(Instr::ABC(OpCode::Halt, 0));
+    program.registers = frame_size;
+    return program;
+}
+
+uint16_t Compiler::allocate() {
+    if (next_reg == UINT16_MAX)
+        throw std::exception("Too many registers");
+    uint16_t reg = next_reg++;
+    if (next_reg > frame_size)
+        frame_size = next_reg;
+    return reg;
+}
+
+StringRef Compiler::addString(std::string_view str) {
+    StringRef ref = { (uint32_t)program.strings.size(), (uint32_t)str.size() };
+    program.strings += str;
+    return ref;
+}
+
+uint32_t Compiler::constant(Constant c) {
+    uint64_t key = (uint64_t)c.type << 32;
+    if (c.type == ConstantType::Int)
+        key |= (uint32_t)c.int_val;
+    else if (c.type == ConstantType::Float)
+        key |= std::bit_cast<uint32_t>(c.float_val);
+    else
+        key |= c.bool_val;
+    if (auto it = number_constants.find(key); it != number_constants.end())
+        return it->second;
+    program.constants.push_back(c);
+    number_constants[key] = program.constants.size() - 1;
+    return program.constants.size() - 1;
+}
+
+uint32_t Compiler::stringConstant(std::string_view str) {
+    if (auto it = string_constants.find(str); it != string_constants.end())
+        return it->second;
+    Constant c;
+    c.type = ConstantType::String;
+    c.str = addString(str);
+    program.constants.push_back(c);
+    string_constants[std::string(str)] = program.constants.size() - 1;
+    return program.constants.size() - 1;
+}
+
+uint16_t Compiler::function(std::string_view name) {
+    if (auto it = function_ids.find(name); it != function_ids.end())
+        return it->second;
+    program.functions.push_back(addString(name));
+    function_ids[std::string(name)] = program.functions.size() - 1;
+    return program.functions.size() - 1;
+}
+
+uint32_t Compiler::emit(Instr instr) {
+    program.code.push_back(instr);
+    return program.code.size() - 1;
+}
+
+uint32_t Compiler::here() {
+    return program.code.size();
+}
+
+void Compiler::patch(uint32_t at, uint32_t target) {
+    program.code[at] = Instr::ABx(program.code[at].op, program.code[at].a, target);
+}
+
+Compiler::Variable Compiler::lookup(std::string_view name) {
+    for (size_t i = scopes.size(); i-- > function_scope;)
+        if (auto it = scopes[i].find(name); it != scopes[i].end())
+            return { it->second, false };
+    if (function_scope != 0)
+        if (auto it = scopes[0].find(name); it != scopes[0].end())
+            return { it->second, true };
+    throw std::exception("Unknown variable");
+}
+
+void Compiler::block(BlockStmt* ast, bool global) {
+    scopes.emplace_back();
+    uint16_t mark = next_reg;
+    for (auto& s : ast->stmts)
+        stmt(s);
+    if (global)
+        for (auto& [name, reg] : scopes.back())
+            program.globals.push_back({ addString(name), reg });
+    next_reg = mark;
+    scopes.pop_back();
+}
+
+void Compiler::procedure(FunctionStmt* ast) {
+    if (procedure_ids.size() == UINT16_MAX)
+        throw std::exception("Too many functions");
+    uint32_t skip = emit(Instr::ABx(OpCode::Jump, 0, 0));
+    uint16_t index = program.procedures.size();
+    program.procedures.push_back({ addString(ast->name), here(), (uint16_t)ast->params.size(), 0 });
+    procedure_ids[std::string(ast->name)] = index;
+
+    size_t outer_scope = function_scope;
+    uint16_t outer_reg = next_reg;
+    uint16_t outer_size = frame_size;
+    function_scope = scopes.size();
+    next_reg = 0;
+    frame_size = 0;
+    scopes.emplace_back();
+    for (auto param : ast->params)
+        scopes.back()[std::string(param)] = allocate();
+    for (auto& s : ast->body->stmts)
+        stmt(s);
+    Constant none;
+    none.type = ConstantType::Int;
+    none.int_val = 0;
+    uint16_t result = allocate();
+    emit(Instr::ABx(OpCode::LoadConst, result, constant(none)));
+    emit(Instr::ABC(OpCode::Return, result));
+    program.procedures[index].registers = frame_size;
+
+    scopes.pop_back();
+    function_scope = outer_scope;
+    next_reg = outer_reg;
+    frame_size = outer_size;
+    patch(skip, here());
+}
+
+void Compiler::call(FnCallExpr* ast, uint16_t base) {
+    auto id = dynamic_cast<IdentifierExpr*>(ast->id_expr);
+    if (id == nullptr)
+        throw std::exception("Expected function name");
+    if (ast->args.size() > UINT16_MAX)
+        throw std::exception("Too many arguments");
+    if (auto procedure = procedure_ids.find(id->id); procedure != procedure_ids.end())
+    {
+        if (!ast->keywords.empty())
+            throw std::exception("Keyword arguments are only supported by builtin functions");
+        for (auto& arg : ast->args)
+            expr(arg, allocate());
+        emit(Instr::ABC(OpCode::CallProc, base, procedure->second, ast->args.size()));
+        return;
+    }
+    if (ast->keywords.size() > UINT8_MAX)
+        throw std::exception("Too many keyword arguments");
+    for (auto& arg : ast->args)
+        expr(arg, allocate());
+    for (auto& keyword : ast->keywords)
+    {
+        emit(Instr::ABx(OpCode::LoadConst, allocate(), stringConstant(keyword.name)));
+        expr(keyword.value, allocate());
+    }
+    auto instr = Instr::ABC(OpCode::Call, base, function(id->id), ast->args.size());
+    instr.d = ast->keywords.size();
+    emit(instr);
+}
+
+void Compiler::stmt(Stmt* ast) {
+    switch (ast->stmt_type) {
+        case StmtType::Declaration: {
+            auto s = dynamic_cast<DeclarationStmt*>(ast);
+            uint16_t reg = allocate();
+            expr(s->right, reg);
+            next_reg = reg + 1;
+            scopes.back()[std::string(s->id->id)] = reg;
+            break;
+        }
+        case StmtType::Assignment: {
+            auto s = dynamic_cast<AssignmentStmt*>(ast);
+            auto id = dynamic_cast<IdentifierExpr*>(s->left);
+            if (id == nullptr)
+                throw std::exception("Expected left expression");
+            uint16_t mark = next_reg;
+            auto variable = lookup(id->id);
+            if (variable.global)
+            {
+                uint16_t value = allocate();
+                expr(s->right, value);
+                emit(Instr::ABx(OpCode::StoreGlobal, value, variable.reg));
+            }
+            else
+                expr(s->right, variable.reg);
+            next_reg = mark;
+            break;
+        }
+        case StmtType::Expression: {
+            auto s = dynamic_cast<ExpressionStmt*>(ast);
+            uint16_t mark = next_reg;
+            expr(s->expr, allocate());
+            next_reg = mark;
+            break;
+        }
+        case StmtType::If: {
+            auto s = dynamic_cast<IfStmt*>(ast);
+            uint16_t mark = next_reg;
+            uint32_t jump_else = emit(Instr::ABx(OpCode::JumpIfFalse, exprReg(s->cond), 0));
+            next_reg = mark;
+            block(s->action);
+            uint32_t jump_end = emit(Instr::ABx(OpCode::Jump, 0, 0));
+            patch(jump_else, here());
+            block(s->else_action);
+            patch(jump_end, here());
+            break;
+        }
+        case StmtType::While: {
+            auto s = dynamic_cast<WhileStmt*>(ast);
+            uint32_t top = here();
+            uint16_t mark = next_reg;
+            uint32_t jump_end = emit(Instr::ABx(OpCode::JumpIfFalse, exprReg(s->cond), 0));
+            next_reg = mark;
+            block(s->action);
+            emit(Instr::ABx(OpCode::Jump, 0, top));
+            patch(jump_end, here());
+            break;
+        }
+        case StmtType::DoWhile: {
+            auto s = dynamic_cast<DoWhileStmt*>(ast);
+            uint32_t top = here();
+            block(s->action);
+            uint16_t mark = next_reg;
+            emit(Instr::ABx(OpCode::JumpIfTrue, exprReg(s->cond), top));
+            next_reg = mark;
+            break;
+        }
+        case StmtType::Block:
+            block(dynamic_cast<BlockStmt*>(ast));
+            break;
+        case StmtType::None:
+            break;
+        case StmtType::Function:
+            procedure(dynamic_cast<FunctionStmt*>(ast));
+            break;
+        case StmtType::Return: {
+            auto s = dynamic_cast<ReturnStmt*>(ast);
+            if (function_scope == 0)
+                throw std::exception("return outside of a function");
+            uint16_t mark = next_reg;
+            uint16_t value = allocate();
+            if (s->value != nullptr)
+                expr(s->value, value);
+            else
+            {
+                Constant none;
+                none.type = ConstantType::Int;
+                none.int_val = 0;
+                emit(Instr::ABx(OpCode::LoadConst, value, constant(none)));
+            }
+            emit(Instr::ABC(OpCode::Return, value));
+            next_reg = mark;
+            break;
+        }
+        default:
+            throw std::exception("Unsupported statement");
+    }
+}
+
+uint16_t Compiler::exprReg(Expr* ast) {
+    if (ast->expr_type == ExprType::Identifier)
+        if (auto variable = lookup(dynamic_cast<IdentifierExpr*>(ast)->id); !variable.global)
+            return variable.reg;
+    uint16_t reg = allocate();
+    expr(ast, reg);
+    return reg;
+}
+
+void Compiler::expr(Expr* ast, uint16_t target) {
+    uint16_t mark = next_reg;
+    switch (ast->expr_type) {
+        case ExprType::Identifier: {
+            auto variable = lookup(dynamic_cast<IdentifierExpr*>(ast)->id);
+            if (variable.global)
+                emit(Instr::ABx(OpCode::LoadGlobal, target, variable.reg));
+            else
+                emit(Instr::ABC(OpCode::Move, target, variable.reg));
+            return;
+        }
+        case ExprType::IntLiteral: {
+            Constant c;
+            c.type = ConstantType::Int;
+            c.int_val = dynamic_cast<IntLiteralExpr*>(ast)->value;
+            emit(Instr::ABx(OpCode::LoadConst, target, constant(c)));
+            return;
+        }
+        case ExprType::FloatLiteral: {
+            Constant c;
+            c.type = ConstantType::Float;
+            c.float_val = dynamic_cast<FloatLiteralExpr*>(ast)->value;
+            emit(Instr::ABx(OpCode::LoadConst, target, constant(c)));
+            return;
+        }
+        case ExprType::BoolLiteral: {
+            Constant c;
+            c.type = ConstantType::Bool;
+            c.bool_val = dynamic_cast<BoolLiteralExpr*>(ast)->value;
+            emit(Instr::ABx(OpCode::LoadConst, target, constant(c)));
+            return;
+        }
+        case ExprType::StringLiteral:
+            emit(Instr::ABx(OpCode::LoadConst, target, stringConstant(dynamic_cast<StringLiteralExpr*>(ast)->value)));
+            return;
+        case ExprType::List: {
+            auto e = dynamic_cast<ListExpr*>(ast);
+            if (e->items.size() > UINT16_MAX)
+                throw std::exception("List literal is too long");
+            uint16_t base = next_reg;
+            for (auto& item : e->items)
+                expr(item, allocate());
+            emit(Instr::ABC(OpCode::MakeList, target, base, e->items.size()));
+            next_reg = mark;
+            return;
+        }
+        case ExprType::FnCall: {
+            uint16_t base = allocate();
+            call(dynamic_cast<FnCallExpr*>(ast), base);
+            if (base != target)
+                emit(Instr::ABC(OpCode::Move, target, base));
+            next_reg = mark;
+            return;
+        }
+        default:
+            break;
+    }
+
+    if (auto op = binaryOpCode(ast->expr_type); op != OpCode::Last)
+    {
+        auto e = dynamic_cast<BinaryOpExpr*>(ast);
+        uint16_t left = exprReg(e->left_expr);
+        uint16_t right = exprReg(e->right_expr);
+        emit(Instr::ABC(op, target, left, right));
+        next_reg = mark;
+        return;
+    }
+    if (auto op = unaryOpCode(ast->expr_type); op != OpCode::Last)
+    {
+        auto e = dynamic_cast<UnaryOpExpr*>(ast);
+        emit(Instr::ABC(op, target, exprReg(e->expr)));
+        next_reg = mark;
+        return;
+    }
+    throw std::exception("Unsupported expression");
+}
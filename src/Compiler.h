@@ -0,0 +1,42 @@
+#pragma once
+#include "AST.h"
+#include "Bytecode.h"
+#include "Hash.h"
+#include <optional>
+#include <unordered_map>
+
+class Compiler {
+    struct Variable {
+        uint16_t reg;
+        bool global; // top-level variable used inside a function
+    };
+
+    Program program;
+    std::vector<std::unordered_map<std::string, uint16_t, StringHash, std::equal_to<>>> scopes;
+    std::unordered_map<std::string, uint32_t, StringHash, std::equal_to<>> string_constants;
+    std::unordered_map<uint64_t, uint32_t> number_constants;
+    std::unordered_map<std::string, uint16_t, StringHash, std::equal_to<>> function_ids;
+    std::unordered_map<std::string, uint16_t, StringHash, std::equal_to<>> procedure_ids;
+    size_t function_scope = 0; // first scope of the function being compiled, 0 at the top level
+    uint16_t next_reg = 0;
+    uint16_t frame_size = 0;
+
+    uint16_t allocate();
+    StringRef addString(std::string_view str);
+    uint32_t constant(Constant c);
+    uint32_t stringConstant(std::string_view str);
+    uint16_t function(std::string_view name);
+    uint32_t emit(Instr instr);
+    uint32_t here();
+    void patch(uint32_t at, uint32_t target);
+    Variable lookup(std::string_view name);
+
+    void stmt(Stmt* ast);
+    void block(BlockStmt* ast, bool global = false);
+    void procedure(FunctionStmt* ast);
+    void call(FnCallExpr* ast, uint16_t base);
+    void expr(Expr* ast, uint16_t target);
+    uint16_t exprReg(Expr* ast);
+public:
+    Program compile(Stmt* ast);
+};
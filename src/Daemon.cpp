@@ -0,0 +1,177 @@
+#include "Daemon.h"
+#include "constants.h"
+#include "Executor.h"
+#include "ScriptLoader.h"
+#include <iostream>
+#ifndef _WIN32
+#include <boost/asio.hpp>
+#include <csignal>
+#include <cstdio>
+#include <unistd.h>
+#endif
+
+Daemon::Daemon(const ProgramArguments& args, const std::filesystem::path& directory)
+    : args(args), directory(directory), database((directory / build_database_name).string()) {
+    database.load();
+    if (args.cache)
+        cache = std::make_unique<OutputCache>(OutputCache::defaultDirectory(), args.cache_size << 20);
+    if (!args.remote_cache.empty())
+        remote = std::make_unique<RemoteCache>(args.remote_cache);
+}
+
+bool Daemon::scriptsChanged() {
+    for (auto& [path, stat] : scripts)
+        if (StatCache::statFile(path.string()) != stat)
+            return true;
+    return false;
+}
+
+void Daemon::configure() {
+    configured = false;
+    graph = BuildGraph();
+    graph.directory = directory;
+    ScriptLoader loader(args.jobs, args.tree_walk);
+    if (args.memo)
+        loader.loadMemo(directory / run_script_memo_name);
+    auto root = loader.load(directory / script_default_name);
+    loader.wait();
+    scripts.clear();
+    for (auto& path : loader.loadedScripts())
+        scripts.emplace_back(path, StatCache::statFile(path.string()));
+    loader.merge(*root, graph);
+    if (args.memo)
+        loader.saveMemo(directory / run_script_memo_name);
+    configured = true;
+}
+
+int Daemon::build() {
+    try {
+        if (!configured || scriptsChanged())
+            configure();
+        auto executor = Executor(args.jobs, &database, nullptr, cache.get(), remote.get());
+        bool success = executor.run(graph);
+        database.save();
+        if (cache != nullptr)
+            cache->trim();
+        return success ? 0 : 1;
+    }
+    catch (std::exception& e) {
+        std::cout << e.what() << '\n';
+        return 1;
+    }
+}
+
+#ifdef _WIN32
+int Daemon::serve(const std::filesystem::path&) {
+    std::cout << "Daemon mode needs Unix domain sockets\n";
+    return 1;
+}
+
+int Daemon::request(const std::filesystem::path&, const std::string&) {
+    std::cout << "Daemon mode needs Unix domain sockets\n";
+    return 1;
+}
+#else
+namespace {
+    using boost::asio::local::stream_protocol;
+
+    // Points stdout and stderr at the client while a build runs, so rule commands write there too
+    class Redirect {
+        int saved_out, saved_err;
+    public:
+        explicit Redirect(int fd) {
+            std::cout.flush();
+            std::fflush(stdout);
+            saved_out = dup(STDOUT_FILENO);
+            saved_err = dup(STDERR_FILENO);
+            dup2(fd, STDOUT_FILENO);
+            dup2(fd, STDERR_FILENO);
+        }
+        ~Redirect() {
+            std::cout.flush();
+            std::fflush(stdout);
+            dup2(saved_out, STDOUT_FILENO);
+            dup2(saved_err, STDERR_FILENO);
+            close(saved_out);
+            close(saved_err);
+            // A client that went away leaves the stream in a failed state
+            std::cout.clear();
+        }
+    };
+
+    void ignoreBrokenPipe(int) { }
+}
+
+int Daemon::serve(const std::filesystem::path& socket_path) {
+    // A handler rather than SIG_IGN, so the disposition isn't inherited by rule commands
+    std::signal(SIGPIPE, ignoreBrokenPipe);
+    boost::asio::io_context context;
+    std::filesystem::remove(socket_path);
+    stream_protocol::acceptor acceptor(context, stream_protocol::endpoint(socket_path.string()));
+    std::cout << "Listening on " << socket_path.string() << std::endl;
+
+    bool stopping = false;
+    while (!stopping)
+    {
+        stream_protocol::socket socket(context);
+        acceptor.accept(socket);
+        boost::system::error_code error;
+        boost::asio::streambuf buffer;
+        boost::asio::read_until(socket, buffer, '\n', error);
+        if (error)
+            continue;
+        std::string command;
+        std::getline(std::istream(&buffer), command);
+
+        // The last byte sent is the exit code, everything before it is output
+        uint8_t code = 0;
+        if (command == "stop")
+            stopping = true;
+        else if (command == "build")
+        {
+            Redirect redirect(socket.native_handle());
+            code = build();
+        }
+        else
+        {
+            std::string message = "Unknown command " + command + '\n';
+            boost::asio::write(socket, boost::asio::buffer(message), error);
+            code = 1;
+        }
+        boost::asio::write(socket, boost::asio::buffer(&code, 1), error);
+    }
+    std::filesystem::remove(socket_path);
+    return 0;
+}
+
+int Daemon::request(const std::filesystem::path& socket_path, const std::string& command) {
+    boost::asio::io_context context;
+    stream_protocol::socket socket(context);
+    boost::system::error_code error;
+    socket.connect(stream_protocol::endpoint(socket_path.string()), error);
+    if (error)
+    {
+        std::cout << "No daemon is listening on " << socket_path.string() << '\n';
+        return 1;
+    }
+    boost::asio::write(socket, boost::asio::buffer(command + '\n'), error);
+
+    // Output is passed through as it arrives, holding back one byte that may turn out to be the exit code
+    char data[4096];
+    bool pending = false;
+    char last = 0;
+    while (!error)
+    {
+        size_t size = socket.read_some(boost::asio::buffer(data), error);
+        if (size == 0)
+            continue;
+        if (pending)
+            std::cout.put(last);
+        std::cout.write(data, size - 1);
+        std::cout.flush();
+        last = data[size - 1];
+        pending = true;
+    }
+    return pending ? (uint8_t)last : 1;
+}
+#endif
@@ -0,0 +1,37 @@
+#pragma once
+#include "args_parser.h"
+#include "BuildGraph.h"
+#include "BuildDatabase.h"
+#include "OutputCache.h"
+#include "RemoteCache.h"
+#include "StatCache.h"
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Keeps the configured build graph, the build database and its stat cache in memory between builds.
+// Clients connect over a Unix socket in the script directory; scripts are evaluated again only when
+// one of them changed, and unchanged files are not hashed again.
+class Daemon {
+    ProgramArguments args;
+    std::filesystem::path directory;
+    BuildGraph graph;
+    BuildDatabase database;
+    std::unique_ptr<OutputCache> cache; // only with --cache
+    std::unique_ptr<RemoteCache> remote; // only with --remote-cache
+    bool configured = false;
+    std::vector<std::pair<std::filesystem::path, FileStat>> scripts; // stats of the scripts the graph came from
+
+    bool scriptsChanged();
+    void configure();
+    int build();
+public:
+    Daemon(const ProgramArguments& args, const std::filesystem::path& directory);
+
+    // Serves build requests until a client asks to stop
+    int serve(const std::filesystem::path& socket_path);
+    // Sends a command to a running daemon, prints its output and returns its exit code
+    static int request(const std::filesystem::path& socket_path, const std::string& command);
+};
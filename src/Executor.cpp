@@ -0,0 +1,233 @@
+#include "Executor.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <cstdlib>
+
+bool Executor::run(BuildGraph& graph, const std::vector<bool>* dirty) {
+    this->graph = &graph;
+    this->dirty = dirty;
+    {
+        Tracer::Span span(tracer, "link", "graph");
+        graph.link();
+    }
+    if (database != nullptr && dirty == nullptr)
+    {
+        Tracer::Span span(tracer, "stat scan", "database");
+        database->scan(graph, pool);
+    }
+    failed = false;
+    started = 0;
+    skipped = 0;
+    prioritize();
+    ready.clear();
+    pending = std::make_unique<std::atomic<size_t>[]>(graph.size());
+    // Roots come from the graph, not from pending: workers start decrementing pending as soon as the first
+    // rule is scheduled, and a rule reaching zero during the scan would otherwise be scheduled twice
+    std::vector<size_t> roots;
+    for (size_t i = 0; i < graph.size(); i++)
+    {
+        pending[i] = graph.rule(i).deps.size();
+        if (graph.rule(i).deps.empty())
+            roots.push_back(i);
+    }
+    for (auto i : roots)
+        schedule(i);
+    // Answers to remote lookups arrive as new tasks, so the pool may drain while some are still out
+    while (true)
+    {
+        pool.wait();
+        std::unique_lock lock(lookups_mutex);
+        if (lookups == 0)
+            break;
+        answered.wait(lock, [this]() { return lookups == 0; });
+    }
+    if (!failed && graph.size() != 0 && skipped == graph.size())
+        std::cout << "Everything is up to date\n";
+    return !failed;
+}
+
+void Executor::prioritize() {
+    priority.assign(graph->size(), 0);
+    std::vector<uint64_t> durations(graph->size());
+    std::vector<bool> known(graph->size());
+    uint64_t total = 0, count = 0;
+    for (size_t i = 0; database != nullptr && i < graph->size(); i++)
+    {
+        if (auto duration = database->duration(graph->rule(i)))
+        {
+            durations[i] = *duration;
+            known[i] = true;
+            total += *duration;
+            count++;
+        }
+    }
+    // Rules that never ran are assumed to take as long as an average one
+    uint64_t estimate = count != 0 ? std::max<uint64_t>(total / count, 1) : 1;
+
+    // Walk the graph from its sinks, link() has already rejected cycles
+    std::vector<size_t> remaining(graph->size());
+    std::vector<size_t> order;
+    for (size_t i = 0; i < graph->size(); i++)
+    {
+        remaining[i] = graph->rule(i).dependents.size();
+        if (remaining[i] == 0)
+            order.push_back(i);
+    }
+    while (!order.empty())
+    {
+        size_t i = order.back();
+        order.pop_back();
+        auto& rule = graph->rule(i);
+        uint64_t longest = 0;
+        for (auto dependent : rule.dependents)
+            longest = std::max(longest, priority[dependent]);
+        priority[i] = longest + (known[i] ? durations[i] : estimate);
+        for (auto dep : rule.deps)
+            if (--remaining[dep] == 0)
+                order.push_back(dep);
+    }
+}
+
+void Executor::schedule(size_t i) {
+    auto lower = [this](size_t a, size_t b) { return priority[a] < priority[b]; };
+    {
+        std::lock_guard lock(ready_mutex);
+        ready.push_back(i);
+        std::push_heap(ready.begin(), ready.end(), lower);
+    }
+    // Every task takes whichever ready rule has the longest path left, not necessarily the one it was submitted for
+    pool.submit([this, lower]() {
+        size_t next;
+        {
+            std::lock_guard lock(ready_mutex);
+            std::pop_heap(ready.begin(), ready.end(), lower);
+            next = ready.back();
+            ready.pop_back();
+        }
+        build(next);
+    });
+}
+
+void Executor::build(size_t i) {
+    if (failed)
+        return;
+    auto& rule = graph->rule(i);
+    bool up_to_date;
+    {
+        Tracer::Span span(tracer, "check ", rule.command, "database");
+        up_to_date = (dirty != nullptr && !(*dirty)[i]) || (database != nullptr && database->upToDate(rule));
+    }
+    if (up_to_date)
+    {
+        skipped++;
+        for (auto dependent : rule.dependents)
+            if (--pending[dependent] == 0)
+                schedule(dependent);
+        return;
+    }
+
+    std::optional<uint64_t> key;
+    if ((cache != nullptr || remote != nullptr) && database != nullptr && !rule.outputs.empty())
+        key = database->actionHash(rule);
+    if (key && cache != nullptr && restoreRule(rule, *key))
+        return finish(i, std::nullopt);
+    if (key && remote != nullptr)
+    {
+        // The worker goes on with other ready rules, the answer comes back as a task of its own
+        {
+            std::lock_guard lock(lookups_mutex);
+            lookups++;
+        }
+        remote->lookup(*key, [this, i, key](std::optional<std::string> body) {
+            // The lookup stays outstanding until complete() is done, otherwise run() could see the pool idle
+            // before this task is queued and no lookups left after it is
+            pool.submit([this, i, key, body = std::move(body)]() mutable {
+                complete(i, key, std::move(body));
+                std::lock_guard lock(lookups_mutex);
+                if (--lookups == 0)
+                    answered.notify_all();
+            });
+        });
+        return;
+    }
+    complete(i, key, std::nullopt);
+}
+
+void Executor::complete(size_t i, std::optional<uint64_t> key, std::optional<std::string> remote_body) {
+    if (failed)
+        return;
+    auto& rule = graph->rule(i);
+    if (remote_body && restoreRemote(rule, *remote_body))
+    {
+        if (cache != nullptr)
+            cache->store(*key, rule);
+        return finish(i, std::nullopt);
+    }
+    auto start = std::chrono::steady_clock::now();
+    if (!runRule(rule))
+    {
+        failed = true;
+        return;
+    }
+    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    if (key && cache != nullptr)
+    {
+        Tracer::Span span(tracer, "cache store ", rule.command, "cache");
+        cache->store(*key, rule);
+    }
+    if (key && remote != nullptr)
+    {
+        if (auto body = RemoteCache::pack(rule))
+            remote->store(*key, std::move(*body));
+    }
+    finish(i, duration.count());
+}
+
+void Executor::finish(size_t i, std::optional<uint64_t> duration) {
+    auto& rule = graph->rule(i);
+    if (database != nullptr)
+        database->record(rule, duration);
+    for (auto dependent : rule.dependents)
+        if (--pending[dependent] == 0)
+            schedule(dependent);
+}
+
+bool Executor::runRule(Rule& rule) {
+    {
+        std::lock_guard lock(output_mutex);
+        std::cout << '[' << ++started << "] " << rule.command << std::endl;
+    }
+    std::string command = "cd \"" + rule.directory.string() + "\" && " + rule.command;
+    Tracer::Span span(tracer, "", rule.command, "rule");
+    int code = std::system(command.c_str());
+    if (code != 0)
+    {
+        std::lock_guard lock(output_mutex);
+        std::cout << "Rule failed with code " << code << ": " << rule.command << '\n';
+        return false;
+    }
+    return true;
+}
+
+bool Executor::restoreRule(Rule& rule, uint64_t key) {
+    {
+        Tracer::Span span(tracer, "cache restore ", rule.command, "cache");
+        if (!cache->restore(key, rule))
+            return false;
+    }
+    std::lock_guard lock(output_mutex);
+    std::cout << '[' << ++started << "] (cached) " << rule.command << std::endl;
+    return true;
+}
+
+bool Executor::restoreRemote(Rule& rule, const std::string& body) {
+    {
+        Tracer::Span span(tracer, "remote restore ", rule.command, "cache");
+        if (!RemoteCache::unpack(body, rule))
+            return false;
+    }
+    std::lock_guard lock(output_mutex);
+    std::cout << '[' << ++started << "] (remote) " << rule.command << std::endl;
+    return true;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include "BuildGraph.h"
+#include "ThreadPool.h"
+#include "BuildDatabase.h"
+#include "OutputCache.h"
+#include "RemoteCache.h"
+#include "Tracer.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+class Executor {
+    ThreadPool pool;
+    std::mutex output_mutex;
+    std::atomic<bool> failed = false;
+    std::atomic<size_t> started = 0;
+    std::atomic<size_t> skipped = 0;
+    std::unique_ptr<std::atomic<size_t>[]> pending;
+    // Longest path in microseconds from each rule to the end of the graph, ready rules run highest first
+    std::vector<uint64_t> priority;
+    std::vector<size_t> ready; // heap ordered by priority
+    std::mutex ready_mutex;
+    BuildGraph* graph = nullptr;
+    const std::vector<bool>* dirty = nullptr;
+    BuildDatabase* database;
+    Tracer* tracer;
+    OutputCache* cache;
+    RemoteCache* remote;
+    size_t lookups = 0; // remote lookups without an answer yet
+    std::mutex lookups_mutex;
+    std::condition_variable answered;
+
+    void prioritize();
+    void schedule(size_t i);
+    void build(size_t i);
+    void complete(size_t i, std::optional<uint64_t> key, std::optional<std::string> remote_body);
+    // duration is the command's time in microseconds, nullopt for restored outputs
+    void finish(size_t i, std::optional<uint64_t> duration);
+    bool runRule(Rule& rule);
+    bool restoreRule(Rule& rule, uint64_t key);
+    bool restoreRemote(Rule& rule, const std::string& body);
+public:
+    // The output caches need the database for input hashes
+    explicit Executor(size_t jobs, BuildDatabase* database = nullptr, Tracer* tracer = nullptr,
+                      OutputCache* cache = nullptr, RemoteCache* remote = nullptr)
+        : pool(jobs), database(database), tracer(tracer), cache(cache), remote(remote) { }
+
+    // With a dirty set only those rules are checked, the rest count as up to date and no stat scan is done
+    bool run(BuildGraph& graph, const std::vector<bool>* dirty = nullptr);
+};
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <functional>
+
+const uint64_t hash_seed = 14695981039346656037ull;
+
+// FNV-1a style mixing over 8-byte words, the tail is hashed byte by byte
+inline uint64_t hashBytes(const char* data, size_t size, uint64_t hash = hash_seed) {
+    const uint64_t prime = 1099511628211ull;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8)
+    {
+        uint64_t word;
+        std::memcpy(&word, data + i, 8);
+        hash ^= word;
+        hash *= prime;
+        hash ^= hash >> 29;
+    }
+    for (; i < size; i++)
+    {
+        hash ^= (unsigned char)data[i];
+        hash *= prime;
+    }
+    return hash;
+}
+
+inline uint64_t hashString(std::string_view str, uint64_t hash = hash_seed) {
+    return hashBytes(str.data(), str.size(), hash);
+}
+
+struct StringHash {
+    using is_transparent = void;
+
+    size_t operator()(std::string_view str) const noexcept {
+        return std::hash<std::string_view>{}(str);
+    }
+};
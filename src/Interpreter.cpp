@@ -1,151 +1,417 @@
 #include "Interpreter.h"
+#include "ScriptLoader.h"
 #include <utility>
 #include <iostream>
 
-std::shared_ptr<Value> identifierHandler(Interpreter* interpreter, Expr* expr) {
+Value identifierHandler(Interpreter* interpreter, Expr* expr) {
     auto e = dynamic_cast<IdentifierExpr*>(expr);
-    auto& name = e->id;
-    ValueID id = interpreter->symbolTable->getVariable(name);
-    return interpreter->memory.get(id);
+    return interpreter->memory.get(e->depth, e->slot);
 }
 
-std::shared_ptr<Value> boolLiteralHandler(Interpreter* interpreter, Expr* expr) {
+Value boolLiteralHandler(Interpreter* interpreter, Expr* expr) {
     auto e = dynamic_cast<BoolLiteralExpr*>(expr);
-    return std::make_shared<Value>(Value::Bool(e->value));
+    return Value::Bool(e->value);
 }
 
-//Value stringLiteralHandler(Interpreter* interpreter, Expr* expr) {
-//    auto e = dynamic_cast<StringLiteralExpr*>(expr);
-//    return Value::String(e->value);
-//}
+Value stringLiteralHandler(Interpreter* interpreter, Expr* expr) {
+    auto e = dynamic_cast<StringLiteralExpr*>(expr);
+    return Value::String(e->value);
+}
 
-std::shared_ptr<Value> intLiteralHandler(Interpreter* interpreter, Expr* expr) {
+Value intLiteralHandler(Interpreter* interpreter, Expr* expr) {
     auto e = dynamic_cast<IntLiteralExpr*>(expr);
-    return std::make_shared<Value>(Value::Int(e->value));
+    return Value::Int(e->value);
 }
 
-std::shared_ptr<Value> floatLiteralHandler(Interpreter* interpreter, Expr* expr) {
+Value floatLiteralHandler(Interpreter* interpreter, Expr* expr) {
     auto e = dynamic_cast<FloatLiteralExpr*>(expr);
-    return std::make_shared<Value>(Value::Float(e->value));
+    return Value::Float(e->value);
 }
 
-std::shared_ptr<Value> negHandler(Interpreter* interpreter, Expr* expr) {
+Value negHandler(Interpreter* interpreter, Expr* expr) {
     auto e = dynamic_cast<UnaryOpExpr*>(expr);
-    auto val = interpreter->eval(e->expr.get());
-    if (val->type == ValueType::Int || val->type == ValueType::Bool)
-        return std::make_shared<Value>(Value::Int(-val->ToInt()));
-    if (val->type == ValueType::Float)
-        return std::make_shared<Value>(Value::Float(-val->ToFloat()));
+    auto val = interpreter->eval(e->expr);
+    if (val.type == ValueType::Int || val.type == ValueType::Bool)
+        return Value::Int(-val.ToInt());
+    if (val.type == ValueType::Float)
+        return Value::Float(-val.ToFloat());
 }
 
-std::shared_ptr<Value> notHandler(Interpreter* interpreter, Expr* expr) {
+Value notHandler(Interpreter* interpreter, Expr* expr) {
     auto e = dynamic_cast<UnaryOpExpr*>(expr);
-    auto val = interpreter->eval(e->expr.get());
-    if (val->IsNumeric())
-        return std::make_shared<Value>(Value::Bool(!val->ToBool()));
+    auto val = interpreter->eval(e->expr);
+    if (val.IsNumeric())
+        return Value::Bool(!val.ToBool());
+}
+
+Value listHandler(Interpreter* interpreter, Expr* expr) {
+    auto e = dynamic_cast<ListExpr*>(expr);
+    std::vector<Value> items;
+    items.reserve(e->items.size());
+    for (auto& item : e->items)
+        items.push_back(interpreter->eval(item));
+    return Value::List(std::move(items));
+}
+
+Value fnCallHandler(Interpreter* interpreter, Expr* expr) {
+    auto e = dynamic_cast<FnCallExpr*>(expr);
+    auto id = dynamic_cast<IdentifierExpr*>(e->id_expr);
+    if (id == nullptr)
+        throw std::exception("Expected function name");
+    if (auto procedure = interpreter->procedures.find(id->id); procedure != interpreter->procedures.end())
+    {
+        if (!e->keywords.empty())
+            throw std::exception("Keyword arguments are only supported by builtin functions");
+        std::vector<Value> args;
+        args.reserve(e->args.size());
+        for (auto& arg : e->args)
+            args.push_back(interpreter->eval(arg));
+        return interpreter->call(procedure->second, args);
+    }
+    auto function = interpreter->functions.find(id->id);
+    if (function == interpreter->functions.end())
+        throw std::exception("Unknown function");
+    Arguments args;
+    args.positional.reserve(e->args.size());
+    for (auto& arg : e->args)
+        args.positional.push_back(interpreter->eval(arg));
+    for (auto& keyword : e->keywords)
+        args.keywords.emplace_back(keyword.name, interpreter->eval(keyword.value));
+    return function->second(interpreter, args);
+}
+
+std::vector<std::string> stringList(const Value& val) {
+    if (val.type == ValueType::String)
+        return { *val.str_val };
+    if (val.type != ValueType::List)
+        throw std::exception("Expected list of files");
+    std::vector<std::string> files;
+    for (auto& item : *val.list_val)
+    {
+        if (item.type != ValueType::String)
+            throw std::exception("Expected file name");
+        files.push_back(*item.str_val);
+    }
+    return files;
+}
+
+Value addRuleFunction(Interpreter* interpreter, Arguments& args) {
+    auto& values = args.positional;
+    if (values.size() != 3 || values[2].type != ValueType::String)
+        throw std::exception("add_rule expects ([inputs], [outputs], \"rule\")");
+    interpreter->buildGraph.addRule(stringList(values[0]), stringList(values[1]), *values[2].str_val);
+    return Value::Bool(true);
+}
+
+Value subdirectoryFunction(Interpreter* interpreter, Arguments& args) {
+    auto& values = args.positional;
+    if (values.empty() || values[0].type != ValueType::String)
+        throw std::exception("subdirectory expects (\"path\", entry=\"name\", args...)");
+    if (interpreter->loader == nullptr || interpreter->script == nullptr)
+        throw std::exception("subdirectory() is not available");
+    std::string entry;
+    if (auto value = args.keyword("entry"))
+    {
+        if (value->type != ValueType::String)
+            throw std::exception("Entry must be a function name");
+        entry = *value->str_val;
+    }
+    std::vector<Value> entry_args(std::make_move_iterator(values.begin() + 1), std::make_move_iterator(values.end()));
+    interpreter->loader->spawn(*interpreter->script, interpreter->buildGraph.directory / *values[0].str_val,
+                               std::move(entry), std::move(entry_args));
+    return Value::Bool(true);
+}
+
+Value runScriptFunction(Interpreter* interpreter, Arguments& args) {
+    auto& values = args.positional;
+    if (values.empty() || values[0].type != ValueType::String)
+        throw std::exception("run_script expects (\"path\", entry=\"name\", args...)");
+    if (interpreter->loader == nullptr)
+        throw std::exception("run_script() is not available");
+    std::string entry;
+    if (auto value = args.keyword("entry"))
+    {
+        if (value->type != ValueType::String)
+            throw std::exception("Entry must be a function name");
+        entry = *value->str_val;
+    }
+    std::vector<Value> entry_args(std::make_move_iterator(values.begin() + 1), std::make_move_iterator(values.end()));
+    return interpreter->loader->runScript(interpreter->script, interpreter->buildGraph.directory / *values[0].str_val,
+                                          entry, std::move(entry_args));
 }
 
-std::shared_ptr<Value> BinOpHandler(Interpreter* interpreter, Expr* expr) {
-    auto e = dynamic_cast<BinaryOpExpr*>(expr);
-    auto val_left = interpreter->eval(e->left_expr.get());
-    auto val_right = interpreter->eval(e->right_expr.get());
-    return std::move(interpreter->DoBinOp(val_left, val_right, expr->expr_type));
+// Same results as the Integer/Integer operations registered in the constructor
+Value intOperation(ExprType op, int lhs, int rhs) {
+    switch (op) {
+        case ExprType::Add: return Value::Int(lhs + rhs);
+        case ExprType::Sub: return Value::Int(lhs - rhs);
+        case ExprType::Mul: return Value::Int(lhs * rhs);
+        case ExprType::Div: return Value::Float((float)lhs / (float)rhs);
+        case ExprType::IntDiv: return Value::Int((float)lhs / (float)rhs);
+        case ExprType::Mod: return Value::Int(lhs % rhs);
+        case ExprType::Eq: return Value::Bool((lhs != 0) == (rhs != 0));
+        case ExprType::NotEq: return Value::Bool((lhs != 0) != (rhs != 0));
+        case ExprType::Greater: return Value::Bool((float)lhs > (float)rhs);
+        case ExprType::Less: return Value::Bool((float)lhs < (float)rhs);
+        case ExprType::GreaterEq: return Value::Bool((float)lhs >= (float)rhs);
+        case ExprType::LessEq: return Value::Bool((float)lhs <= (float)rhs);
+        case ExprType::And: return Value::Bool(lhs && rhs);
+        case ExprType::Or: return Value::Bool(lhs || rhs);
+        default: throw std::exception("Unsupported operand types");
+    }
 }
 
-std::shared_ptr<Value> Interpreter::DoBinOp(const std::shared_ptr<Value>& v1, const std::shared_ptr<Value>& v2, ExprType type) {
-    for (auto i : properties[v1->type])
+// Same results as the Numeric/Numeric operations registered in the constructor
+Value floatOperation(ExprType op, float lhs, float rhs) {
+    switch (op) {
+        case ExprType::Add: return Value::Float(lhs + rhs);
+        case ExprType::Sub: return Value::Float(lhs - rhs);
+        case ExprType::Mul: return Value::Float(lhs * rhs);
+        case ExprType::Div: return Value::Float(lhs / rhs);
+        case ExprType::IntDiv: return Value::Int(lhs / rhs);
+        case ExprType::Eq: return Value::Bool((lhs != 0) == (rhs != 0));
+        case ExprType::NotEq: return Value::Bool((lhs != 0) != (rhs != 0));
+        case ExprType::Greater: return Value::Bool(lhs > rhs);
+        case ExprType::Less: return Value::Bool(lhs < rhs);
+        case ExprType::GreaterEq: return Value::Bool(lhs >= rhs);
+        case ExprType::LessEq: return Value::Bool(lhs <= rhs);
+        case ExprType::And: return Value::Bool(lhs != 0 && rhs != 0);
+        case ExprType::Or: return Value::Bool(lhs != 0 || rhs != 0);
+        default: throw std::exception("Unsupported operand types");
+    }
+}
+
+bool isFloatPair(const Value& v1, const Value& v2) {
+    return v1.IsNumeric() && v2.IsNumeric() && (v1.type == ValueType::Float || v2.type == ValueType::Float);
+}
+
+Value BinOpHandler(Interpreter* interpreter, Expr* expr) {
+    auto e = static_cast<BinaryOpExpr*>(expr);
+    auto val_left = interpreter->eval(e->left_expr);
+    auto val_right = interpreter->eval(e->right_expr);
+    auto result = interpreter->DoBinOp(val_left, val_right, e->op);
+    // Quickening: specialize the node for the operand types it has just seen
+    if (e->quickenable)
     {
-        for (auto k : properties[v2->type])
-        {
-            if (binaryOperations.contains({ .opType = type, .t1 = i, .t2 = k }))
-                return std::move(binaryOperations[{ .opType = type, .t1 = i, .t2 = k }](this, v1, v2));
-        }
+        if (val_left.type == ValueType::Int && val_right.type == ValueType::Int)
+            e->expr_type = ExprType::IntBinaryOp;
+        else if (isFloatPair(val_left, val_right) && e->op != ExprType::Mod)
+            e->expr_type = ExprType::FloatBinaryOp;
     }
+    return result;
+}
+
+// Falls back to the generic path for good once a type guard fails
+Value deoptimize(Interpreter* interpreter, BinaryOpExpr* e, const Value& v1, const Value& v2) {
+    e->expr_type = e->op;
+    e->quickenable = false;
+    return interpreter->DoBinOp(v1, v2, e->op);
+}
+
+Value intBinOpHandler(Interpreter* interpreter, Expr* expr) {
+    auto e = static_cast<BinaryOpExpr*>(expr);
+    auto val_left = interpreter->eval(e->left_expr);
+    auto val_right = interpreter->eval(e->right_expr);
+    if (val_left.type == ValueType::Int && val_right.type == ValueType::Int)
+        return intOperation(e->op, val_left.int_val, val_right.int_val);
+    return deoptimize(interpreter, e, val_left, val_right);
+}
+
+Value floatBinOpHandler(Interpreter* interpreter, Expr* expr) {
+    auto e = static_cast<BinaryOpExpr*>(expr);
+    auto val_left = interpreter->eval(e->left_expr);
+    auto val_right = interpreter->eval(e->right_expr);
+    if (isFloatPair(val_left, val_right))
+        return floatOperation(e->op, val_left.ToFloat(), val_right.ToFloat());
+    return deoptimize(interpreter, e, val_left, val_right);
+}
+
+Value Interpreter::DoBinOp(const Value& v1, const Value& v2, ExprType type) {
+    auto operation = binaryTable[(int)type][(int)v1.type][(int)v2.type];
+    if (operation == nullptr)
+        throw std::exception("Unsupported operand types");
+    return (*operation)(this, v1, v2);
+}
+
+void Interpreter::buildBinaryTable() {
+    // Same search order the operand properties were tried in at runtime: the first registered match wins
+    for (int type = 0; type < (int)ExprType::Last; type++)
+        for (int t1 = 0; t1 < (int)ValueType::Last; t1++)
+            for (int t2 = 0; t2 < (int)ValueType::Last; t2++)
+            {
+                binaryTable[type][t1][t2] = nullptr;
+                for (auto i : properties[(ValueType)t1])
+                {
+                    for (auto k : properties[(ValueType)t2])
+                    {
+                        auto it = binaryOperations.find({ .opType = (ExprType)type, .t1 = i, .t2 = k });
+                        if (it != binaryOperations.end())
+                        {
+                            binaryTable[type][t1][t2] = &it->second;
+                            break;
+                        }
+                    }
+                    if (binaryTable[type][t1][t2] != nullptr)
+                        break;
+                }
+            }
 }
 
-ValueID LeftIdentifierHandler(Interpreter* interpreter, Expr* expr) {
+Value& LeftIdentifierHandler(Interpreter* interpreter, Expr* expr) {
     auto e = dynamic_cast<IdentifierExpr*>(expr);
-    auto& name = e->id;
-    ValueID id = interpreter->symbolTable->getVariable(name);
-    return id;
+    return interpreter->memory.get(e->depth, e->slot);
+}
+
+void printFrame(Interpreter* interpreter, BlockStmt* block) {
+    if (!interpreter->verbose)
+        return;
+    std::cout << "Symbol table values:\n"; // Todo
+    for (size_t i = 0; i < block->names.size(); i++)
+        std::cout << block->names[i] << '\t' << interpreter->memory.get(0, i) << '\n';
 }
 
 void blockHandler(Interpreter* interpreter, Stmt* stmt) {
     auto s = dynamic_cast<BlockStmt*>(stmt);
-    interpreter->symbolTable = std::make_shared<SymbolTable>(interpreter->symbolTable);
+    interpreter->memory.pushFrame(s->names.size());
     for (auto& i : s->stmts) {
-        interpreter->exec(i.get());
+        interpreter->exec(i);
+        if (interpreter->returning)
+            break;
     }
-    interpreter->symbolTable->printValues(); // Todo
-    interpreter->symbolTable = interpreter->symbolTable->up;
+    printFrame(interpreter, s);
+    interpreter->memory.popFrame();
 }
 
 void declarationHandler(Interpreter* interpreter, Stmt* stmt) {
     auto s = dynamic_cast<DeclarationStmt*>(stmt);
-    auto val = interpreter->eval(s->right.get());
-    auto name = s->id->id;
-    ValueID id = interpreter->memory.newOp(std::move(val));
-    interpreter->symbolTable->addVariable(name, id);
+    auto val = interpreter->eval(s->right);
+    interpreter->memory.get(0, s->id->slot) = std::move(val);
+}
+
+void expressionHandler(Interpreter* interpreter, Stmt* stmt) {
+    auto s = dynamic_cast<ExpressionStmt*>(stmt);
+    interpreter->eval(s->expr);
 }
 
 void assignmentHandler(Interpreter* interpreter, Stmt* stmt) {
     auto s = dynamic_cast<AssignmentStmt*>(stmt);
-    auto val = interpreter->eval(s->right.get());
+    auto val = interpreter->eval(s->right);
     if (!s->left->left)
         throw std::exception("Expected left expression");
-    ValueID id = interpreter->eval_left(s->left.get());
-    interpreter->memory.set(id, std::move(val));
+    interpreter->eval_left(s->left) = std::move(val);
 }
 
 void ifHandler(Interpreter* interpreter, Stmt* stmt) {
     auto s = dynamic_cast<IfStmt*>(stmt);
-    auto val = interpreter->eval(s->cond.get());
-    if (val->ToBool()) {
-        interpreter->exec(s->action.get());
+    auto val = interpreter->eval(s->cond);
+    if (val.ToBool()) {
+        interpreter->exec(s->action);
     } else {
-        interpreter->exec(s->else_action.get());
+        interpreter->exec(s->else_action);
     }
 }
 
 void whileHandler(Interpreter* interpreter, Stmt* stmt) {
     auto s = dynamic_cast<WhileStmt*>(stmt);
-    while (interpreter->eval(s->cond.get())->ToBool())
-        interpreter->exec(s->action.get());
+    while (!interpreter->returning && interpreter->eval(s->cond).ToBool())
+        interpreter->exec(s->action);
 }
 
 void doWhileHandler(Interpreter* interpreter, Stmt* stmt) {
     auto s = dynamic_cast<DoWhileStmt*>(stmt);
     do
-        interpreter->exec(s->action.get());
-    while (interpreter->eval(s->cond.get())->ToBool());
+        interpreter->exec(s->action);
+    while (!interpreter->returning && interpreter->eval(s->cond).ToBool());
 }
 
 void noneHandler(Interpreter* interpreter, Stmt* stmt) {
 
 }
 
-std::shared_ptr<Value> Interpreter::eval(Expr* ast) {
-    return std::move(expr_handlers[(int)ast->expr_type](this, ast));
+void functionHandler(Interpreter* interpreter, Stmt* stmt) {
+    auto s = dynamic_cast<FunctionStmt*>(stmt);
+    interpreter->procedures[std::string(s->name)] = s;
+}
+
+void returnHandler(Interpreter* interpreter, Stmt* stmt) {
+    auto s = dynamic_cast<ReturnStmt*>(stmt);
+    interpreter->return_value = s->value != nullptr ? interpreter->eval(s->value) : Value();
+    interpreter->returning = true;
+}
+
+Value Interpreter::call(FunctionStmt* function, std::vector<Value>& args) {
+    if (args.size() != function->params.size())
+        throw std::exception("Wrong number of arguments");
+    memory.pushFrame(function->body->names.size());
+    for (size_t i = 0; i < args.size(); i++)
+        memory.get(0, i) = std::move(args[i]);
+    for (auto& s : function->body->stmts) {
+        exec(s);
+        if (returning)
+            break;
+    }
+    memory.popFrame();
+    returning = false;
+    Value result = std::move(return_value);
+    return_value = Value();
+    return result;
+}
+
+Value Interpreter::run(Stmt* ast, std::string_view entry, std::vector<Value>& args) {
+    auto root = dynamic_cast<BlockStmt*>(ast);
+    if (root == nullptr)
+        throw std::exception("Expected block at the top level");
+    memory.pushFrame(root->names.size());
+    for (auto& s : root->stmts)
+        exec(s);
+    Value result;
+    if (!entry.empty())
+    {
+        auto procedure = procedures.find(entry);
+        if (procedure == procedures.end())
+            throw std::exception("Unknown entry function");
+        result = call(procedure->second, args);
+    }
+    printFrame(this, root);
+    memory.popFrame();
+    return result;
+}
+
+Value Interpreter::eval(Expr* ast) {
+    if (profiler != nullptr)
+    {
+        Profiler::Scope scope(profiler, ast);
+        return expr_handlers[(int)ast->expr_type](this, ast);
+    }
+    return expr_handlers[(int)ast->expr_type](this, ast);
 }
 
 void Interpreter::exec(Stmt* ast) {
+    if (profiler != nullptr)
+    {
+        Profiler::Scope scope(profiler, ast);
+        stmt_handlers[(int)ast->stmt_type](this, ast);
+        return;
+    }
     stmt_handlers[(int)ast->stmt_type](this, ast);
 }
 
-ValueID Interpreter::eval_left(Expr* ast) {
+Value& Interpreter::eval_left(Expr* ast) {
     return left_expr_handlers[(int)ast->expr_type](this, ast);
 }
 
 Interpreter::Interpreter() {
-    symbolTable = std::make_shared<SymbolTable>();
-
     expr_handlers[(int)ExprType::Identifier] = identifierHandler;
     expr_handlers[(int)ExprType::BoolLiteral] = boolLiteralHandler;
-    //expr_handlers[(int)ExprType::StringLiteral] = stringLiteralHandler;
+    expr_handlers[(int)ExprType::StringLiteral] = stringLiteralHandler;
     expr_handlers[(int)ExprType::IntLiteral] = intLiteralHandler;
     expr_handlers[(int)ExprType::FloatLiteral] = floatLiteralHandler;
     expr_handlers[(int)ExprType::Mul] = BinOpHandler;
     expr_handlers[(int)ExprType::Div] = BinOpHandler;
+    expr_handlers[(int)ExprType::IntDiv] = BinOpHandler;
+    expr_handlers[(int)ExprType::Mod] = BinOpHandler;
+    expr_handlers[(int)ExprType::And] = BinOpHandler;
+    expr_handlers[(int)ExprType::Or] = BinOpHandler;
     expr_handlers[(int)ExprType::Add] = BinOpHandler;
     expr_handlers[(int)ExprType::Sub] = BinOpHandler;
     expr_handlers[(int)ExprType::Neg] = negHandler;
@@ -156,23 +422,34 @@ Interpreter::Interpreter() {
     expr_handlers[(int)ExprType::GreaterEq] = BinOpHandler;
     expr_handlers[(int)ExprType::LessEq] = BinOpHandler;
     expr_handlers[(int)ExprType::Not] = notHandler;
+    expr_handlers[(int)ExprType::List] = listHandler;
+    expr_handlers[(int)ExprType::FnCall] = fnCallHandler;
+    expr_handlers[(int)ExprType::IntBinaryOp] = intBinOpHandler;
+    expr_handlers[(int)ExprType::FloatBinaryOp] = floatBinOpHandler;
     left_expr_handlers[(int)ExprType::Identifier] = LeftIdentifierHandler;
 
     stmt_handlers[(int)StmtType::Declaration] = declarationHandler;
     stmt_handlers[(int)StmtType::Assignment] = assignmentHandler;
+    stmt_handlers[(int)StmtType::Expression] = expressionHandler;
     stmt_handlers[(int)StmtType::Block] = blockHandler;
     stmt_handlers[(int)StmtType::If] = ifHandler;
     stmt_handlers[(int)StmtType::While] = whileHandler;
     stmt_handlers[(int)StmtType::DoWhile] = doWhileHandler;
     stmt_handlers[(int)StmtType::None] = noneHandler;
+    stmt_handlers[(int)StmtType::Function] = functionHandler;
+    stmt_handlers[(int)StmtType::Return] = returnHandler;
+
+    functions["add_rule"] = addRuleFunction;
+    functions["subdirectory"] = subdirectoryFunction;
+    functions["run_script"] = runScriptFunction;
 
     addOp({ .opType = ExprType::Mul, .t1 = ValueProperty::Integer, .t2 = ValueProperty::Integer },
-          [](Interpreter* interpreter, const std::shared_ptr<Value>& v1, const std::shared_ptr<Value>& v2){
-            return std::make_shared<Value>(Value::Int(v1->ToInt() * v2->ToInt()));
+          [](Interpreter* interpreter, const Value& v1, const Value& v2){
+            return Value::Int(v1.ToInt() * v2.ToInt());
         });
     addOp({ .opType = ExprType::Mul, .t1 = ValueProperty::Numeric, .t2 = ValueProperty::Numeric },
-          [](Interpreter* interpreter, const std::shared_ptr<Value>& v1, const std::shared_ptr<Value>& v2){
-              return std::make_shared<Value>(Value::Float(v1->ToFloat() * v2->ToFloat()));
+          [](Interpreter* interpreter, const Value& v1, const Value& v2){
+              return Value::Float(v1.ToFloat() * v2.ToFloat());
           });
     // Todo
     //addOp({ .opType = ExprType::Mul, .t1 = ValueProperty::List, .t2 = ValueProperty::Integer },
@@ -180,72 +457,73 @@ Interpreter::Interpreter() {
     //          return Value::Int(v1.ToInt() * v2.ToInt());
     //      });
     addOp({ .opType = ExprType::Div, .t1 = ValueProperty::Numeric, .t2 = ValueProperty::Numeric },
-          [](Interpreter* interpreter, const std::shared_ptr<Value>& v1, const std::shared_ptr<Value>& v2){
-              return std::make_shared<Value>(Value::Float(v1->ToFloat() / v2->ToFloat()));
+          [](Interpreter* interpreter, const Value& v1, const Value& v2){
+              return Value::Float(v1.ToFloat() / v2.ToFloat());
           });
     addOp({ .opType = ExprType::IntDiv, .t1 = ValueProperty::Numeric, .t2 = ValueProperty::Numeric },
-          [](Interpreter* interpreter, const std::shared_ptr<Value>& v1, const std::shared_ptr<Value>& v2){
-              return std::make_shared<Value>(Value::Int(v1->ToFloat() / v2->ToFloat()));
+          [](Interpreter* interpreter, const Value& v1, const Value& v2){
+              return Value::Int(v1.ToFloat() / v2.ToFloat());
           });
     addOp({ .opType = ExprType::Add, .t1 = ValueProperty::Numeric, .t2 = ValueProperty::Numeric },
-          [](Interpreter* interpreter, const std::shared_ptr<Value>& v1, const std::shared_ptr<Value>& v2){
-              return std::make_shared<Value>(Value::Float(v1->ToFloat() + v2->ToFloat()));
+          [](Interpreter* interpreter, const Value& v1, const Value& v2){
+              return Value::Float(v1.ToFloat() + v2.ToFloat());
           });
     addOp({ .opType = ExprType::Add, .t1 = ValueProperty::Integer, .t2 = ValueProperty::Integer },
-          [](Interpreter* interpreter, const std::shared_ptr<Value>& v1, const std::shared_ptr<Value>& v2){
-              return std::make_shared<Value>(Value::Int(v1->ToInt() + v2->ToInt()));
+          [](Interpreter* interpreter, const Value& v1, const Value& v2){
+              return Value::Int(v1.ToInt() + v2.ToInt());
           });
     addOp({ .opType = ExprType::Sub, .t1 = ValueProperty::Numeric, .t2 = ValueProperty::Numeric },
-          [](Interpreter* interpreter, const std::shared_ptr<Value>& v1, const std::shared_ptr<Value>& v2){
-              return std::make_shared<Value>(Value::Float(v1->ToFloat() - v2->ToFloat()));
+          [](Interpreter* interpreter, const Value& v1, const Value& v2){
+              return Value::Float(v1.ToFloat() - v2.ToFloat());
           });
     addOp({ .opType = ExprType::Sub, .t1 = ValueProperty::Integer, .t2 = ValueProperty::Integer },
-          [](Interpreter* interpreter, const std::shared_ptr<Value>& v1, const std::shared_ptr<Value>& v2){
-              return std::make_shared<Value>(Value::Int(v1->ToInt() - v2->ToInt()));
+          [](Interpreter* interpreter, const Value& v1, const Value& v2){
+              return Value::Int(v1.ToInt() - v2.ToInt());
           });
     addOp({ .opType = ExprType::Eq, .t1 = ValueProperty::Numeric, .t2 = ValueProperty::Numeric },
-          [](Interpreter* interpreter, const std::shared_ptr<Value>& v1, const std::shared_ptr<Value>& v2){
-              return std::make_shared<Value>(Value::Bool(v1->ToBool() == v2->ToBool()));
+          [](Interpreter* interpreter, const Value& v1, const Value& v2){
+              return Value::Bool(v1.ToBool() == v2.ToBool());
           });
     addOp({ .opType = ExprType::NotEq, .t1 = ValueProperty::Numeric, .t2 = ValueProperty::Numeric },
-          [](Interpreter* interpreter, const std::shared_ptr<Value>& v1, const std::shared_ptr<Value>& v2){
-              return std::make_shared<Value>(Value::Bool(v1->ToBool() != v2->ToBool()));
+          [](Interpreter* interpreter, const Value& v1, const Value& v2){
+              return Value::Bool(v1.ToBool() != v2.ToBool());
           });
     addOp({ .opType = ExprType::Greater, .t1 = ValueProperty::Numeric, .t2 = ValueProperty::Numeric },
-          [](Interpreter* interpreter, const std::shared_ptr<Value>& v1, const std::shared_ptr<Value>& v2){
-              return std::make_shared<Value>(Value::Bool(v1->ToFloat() > v2->ToFloat()));
+          [](Interpreter* interpreter, const Value& v1, const Value& v2){
+              return Value::Bool(v1.ToFloat() > v2.ToFloat());
           });
     addOp({ .opType = ExprType::GreaterEq, .t1 = ValueProperty::Numeric, .t2 = ValueProperty::Numeric },
-          [](Interpreter* interpreter, const std::shared_ptr<Value>& v1, const std::shared_ptr<Value>& v2){
-              return std::make_shared<Value>(Value::Bool(v1->ToFloat() >= v2->ToFloat()));
+          [](Interpreter* interpreter, const Value& v1, const Value& v2){
+              return Value::Bool(v1.ToFloat() >= v2.ToFloat());
           });
     addOp({ .opType = ExprType::Less, .t1 = ValueProperty::Numeric, .t2 = ValueProperty::Numeric },
-          [](Interpreter* interpreter, const std::shared_ptr<Value>& v1, const std::shared_ptr<Value>& v2){
-              return std::make_shared<Value>(Value::Bool(v1->ToFloat() < v2->ToFloat()));
+          [](Interpreter* interpreter, const Value& v1, const Value& v2){
+              return Value::Bool(v1.ToFloat() < v2.ToFloat());
           });
     addOp({ .opType = ExprType::LessEq, .t1 = ValueProperty::Numeric, .t2 = ValueProperty::Numeric },
-          [](Interpreter* interpreter, const std::shared_ptr<Value>& v1, const std::shared_ptr<Value>& v2){
-              return std::make_shared<Value>(Value::Bool(v1->ToFloat() <= v2->ToFloat()));
+          [](Interpreter* interpreter, const Value& v1, const Value& v2){
+              return Value::Bool(v1.ToFloat() <= v2.ToFloat());
           });
     addOp({ .opType = ExprType::Or, .t1 = ValueProperty::Numeric, .t2 = ValueProperty::Numeric },
-          [](Interpreter* interpreter, const std::shared_ptr<Value>& v1, const std::shared_ptr<Value>& v2){
-              return std::make_shared<Value>(Value::Bool(v1->ToBool() || v2->ToBool()));
+          [](Interpreter* interpreter, const Value& v1, const Value& v2){
+              return Value::Bool(v1.ToBool() || v2.ToBool());
           });
     addOp({ .opType = ExprType::And, .t1 = ValueProperty::Numeric, .t2 = ValueProperty::Numeric },
-          [](Interpreter* interpreter, const std::shared_ptr<Value>& v1, const std::shared_ptr<Value>& v2){
-              return std::make_shared<Value>(Value::Bool(v1->ToBool() && v2->ToBool()));
+          [](Interpreter* interpreter, const Value& v1, const Value& v2){
+              return Value::Bool(v1.ToBool() && v2.ToBool());
           });
     addOp({ .opType = ExprType::Mod, .t1 = ValueProperty::Integer, .t2 = ValueProperty::Integer },
-          [](Interpreter* interpreter, const std::shared_ptr<Value>& v1, const std::shared_ptr<Value>& v2){
-              return std::make_shared<Value>(Value::Int(v1->ToInt() % v2->ToInt()));
+          [](Interpreter* interpreter, const Value& v1, const Value& v2){
+              return Value::Int(v1.ToInt() % v2.ToInt());
           });
+    buildBinaryTable();
 }
 
-void Interpreter::addOp(operation op, const std::function<std::shared_ptr<Value>(Interpreter* interpreter, const std::shared_ptr<Value>& v1, const std::shared_ptr<Value>& v2)>& f) {
+void Interpreter::addOp(operation op, const BinaryOperation& f) {
     binaryOperations[op] = f;
     if (op.t1 == op.t2)
         return;
-    binaryOperations[{ .opType = op.opType, .t1 = op.t2, .t2 = op.t1 }] = [&f](Interpreter* interpreter, const std::shared_ptr<Value>& v1, const std::shared_ptr<Value>& v2) {
+    binaryOperations[{ .opType = op.opType, .t1 = op.t2, .t2 = op.t1 }] = [f](Interpreter* interpreter, const Value& v1, const Value& v2) {
         return f(interpreter, v2, v1);
     };
 }
\ No newline at end of file
@@ -4,7 +4,26 @@
 #include "values.h"
 #include <boost/container_hash/hash.hpp>
 #include <utility>
-#include "SymbolTable.h"
+#include "Memory.h"
+#include "BuildGraph.h"
+#include "Hash.h"
+#include "Profiler.h"
+
+class ScriptLoader;
+struct Script;
+
+// Arguments of a builtin call, keyword arguments keep the order they were written in
+struct Arguments {
+    std::vector<Value> positional;
+    std::vector<std::pair<std::string_view, Value>> keywords;
+
+    const Value* keyword(std::string_view name) const {
+        for (auto& [key, value] : keywords)
+            if (key == name)
+                return &value;
+        return nullptr;
+    }
+};
 
 enum class ValueProperty {
     Numeric, Integer, List
@@ -38,12 +57,28 @@ struct std::hash<operation>
 
 class Interpreter
 {
-    std::unordered_map<operation, std::function<std::shared_ptr<Value>(Interpreter* interpreter, const std::shared_ptr<Value>& v1, const std::shared_ptr<Value>& v2)>> binaryOperations;
-    void addOp(operation op, const std::function<std::shared_ptr<Value>(Interpreter* interpreter, const std::shared_ptr<Value>& v1, const std::shared_ptr<Value>& v2)>& f);
+    using BinaryOperation = std::function<Value(Interpreter* interpreter, const Value& v1, const Value& v2)>;
+
+    std::unordered_map<operation, BinaryOperation> binaryOperations;
+    // Operation for every [operator][left type][right type], resolved from binaryOperations and properties
+    // once in the constructor, nullptr where the operand types are unsupported
+    const BinaryOperation* binaryTable[(int)ExprType::Last][(int)ValueType::Last][(int)ValueType::Last] = { };
+    void addOp(operation op, const BinaryOperation& f);
+    void buildBinaryTable();
 public:
-    std::shared_ptr<SymbolTable> symbolTable;
+    using Function = std::function<Value(Interpreter* interpreter, Arguments& args)>;
+
     Memory memory;
-    std::shared_ptr<Value> DoBinOp(const std::shared_ptr<Value>& v1, const std::shared_ptr<Value>& v2, ExprType type);
+    BuildGraph buildGraph;
+    std::unordered_map<std::string, Function, StringHash, std::equal_to<>> functions;
+    std::unordered_map<std::string, FunctionStmt*, StringHash, std::equal_to<>> procedures;
+    Value return_value;
+    bool returning = false;
+    bool verbose = true;
+    ScriptLoader* loader = nullptr;
+    Script* script = nullptr;
+    Profiler* profiler = nullptr;
+    Value DoBinOp(const Value& v1, const Value& v2, ExprType type);
     std::unordered_map<ValueType, std::vector<ValueProperty>> properties = {
             std::pair<ValueType, std::vector<ValueProperty>>(ValueType::Bool, { ValueProperty::Integer, ValueProperty::Numeric }),
             std::pair<ValueType, std::vector<ValueProperty>>(ValueType::Int, { ValueProperty::Integer, ValueProperty::Numeric }),
@@ -51,12 +86,16 @@ public:
             std::pair<ValueType, std::vector<ValueProperty>>(ValueType::String, {ValueProperty::List }),
     };
 
-    std::function<std::shared_ptr<Value>(Interpreter* interpreter, Expr* expr)> expr_handlers[(int)ExprType::Last];
-    std::function<ValueID(Interpreter* interpreter, Expr* expr)> left_expr_handlers[(int)ExprType::Last];
+    std::function<Value(Interpreter* interpreter, Expr* expr)> expr_handlers[(int)ExprType::Last];
+    std::function<Value&(Interpreter* interpreter, Expr* expr)> left_expr_handlers[(int)ExprType::Last];
     std::function<void(Interpreter* interpreter, Stmt* stmt)> stmt_handlers[(int)StmtType::Last];
     Interpreter();
+    Interpreter(const Interpreter&) = delete;
+    Interpreter& operator=(const Interpreter&) = delete;
 
-    std::shared_ptr<Value> eval(Expr* ast);
+    Value eval(Expr* ast);
     void exec(Stmt* ast);
-    ValueID eval_left(Expr* ast);
+    Value& eval_left(Expr* ast);
+    Value call(FunctionStmt* function, std::vector<Value>& args);
+    Value run(Stmt* ast, std::string_view entry, std::vector<Value>& args);
 };
\ No newline at end of file
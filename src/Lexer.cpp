@@ -1,6 +1,7 @@
 #include "Lexer.h"
 #include <cctype>
 #include <iostream>
+#include "Scan.h"
 
 char Lexer::current() {
     if (cur_i < code_length)
@@ -14,89 +15,75 @@ char Lexer::next() {
     return '\0';
 }
 
+void Lexer::seek(size_t i) {
+    cur_i = i;
+    next_i = i + 1;
+}
+
 char Lexer::move() {
     cur_i++;
     next_i++;
     return current();
 }
 
-std::list<Token> Lexer::tokenize(std::string code)
+TokenList Lexer::tokenize(std::string_view code)
 {
     this->code = code;
     code_length = code.size();
     cur_i = 0;
     next_i = 1;
 
-    std::list<Token> tokens;
+    TokenList tokens;
+    tokens.source = code;
+    tokens.tokens.reserve(code_length / 6 + 1);
+    result = &tokens;
     Token token;
     do
     {
         token = getNextToken();
-        tokens.push_back(token);
+        tokens.tokens.push_back(token);
         if (token.type == TokenType::Error)
         {
-            std::cout << token.string_val.value() << "\n";
+            std::cout << tokens.text(token) << "\n";
             break;
         }
     } while (token.type != TokenType::EOI);
-    return std::move(tokens);
-}
-
-Lexer::Lexer() {
-    word_to_token["if"] = Token(TokenType::If);
-    word_to_token["else"] = Token(TokenType::Else);
-    word_to_token["while"] = Token(TokenType::While);
-    word_to_token["for"] = Token(TokenType::For);
-    word_to_token["foreach"] = Token(TokenType::Foreach);
-    word_to_token["do"] = Token(TokenType::Do);
-    word_to_token["in"] = Token(TokenType::In);
-    word_to_token["var"] = Token(TokenType::Var);
-    word_to_token["const"] = Token(TokenType::Const);
-    word_to_token["fn"] = Token(TokenType::Fn);
-    word_to_token["true"] = Token::BoolLiteral(true);
-    word_to_token["false"] = Token::BoolLiteral(false);
-    word_to_token["int"] = Token(TokenType::IntType);
-    word_to_token["float"] = Token(TokenType::FloatType);
-    word_to_token["bool"] = Token(TokenType::BoolType);
-    word_to_token["string"] = Token(TokenType::StringType);
-
-    op_to_token[">"] = Token(TokenType::Greater);
-    op_to_token["<"] = Token(TokenType::Less);
-    op_to_token["="] = Token(TokenType::Assign);
-    op_to_token["=="] = Token(TokenType::Equal);
-    op_to_token[";"] = Token(TokenType::Semicolon);
-    op_to_token[":"] = Token(TokenType::Colon);
-    op_to_token["&&"] = Token(TokenType::And);
-    op_to_token["||"] = Token(TokenType::Or);
-    op_to_token["!"] = Token(TokenType::Not);
-    op_to_token["!="] = Token(TokenType::NotEqual);
-    op_to_token[","] = Token(TokenType::Comma);
-    op_to_token["."] = Token(TokenType::Dot);
-    op_to_token["+"] = Token(TokenType::Plus);
-    op_to_token["-"] = Token(TokenType::Minus);
-    op_to_token["*"] = Token(TokenType::Asterisk);
-    op_to_token["/"] = Token(TokenType::Slash);
-    op_to_token["\\"] = Token(TokenType::BackSlash);
-    op_to_token["%"] = Token(TokenType::Percent);
-    op_to_token["("] = Token(TokenType::LParent);
-    op_to_token[")"] = Token(TokenType::RParent);
-    op_to_token["["] = Token(TokenType::LBracket);
-    op_to_token["]"] = Token(TokenType::RBracket);
-    op_to_token["{"] = Token(TokenType::LBrace);
-    op_to_token["}"] = Token(TokenType::RBrace);
-    op_to_token["*="] = Token(TokenType::AsteriskEqual);
-    op_to_token["/="] = Token(TokenType::SlashEqual);
-    op_to_token["+="] = Token(TokenType::PlusEqual);
-    op_to_token["-="] = Token(TokenType::MinusEqual);
-    op_to_token["%"] = Token(TokenType::Percent);
-    op_to_token["//"] = Token(TokenType::DoubleSlash);
+    result = nullptr;
+    tokens.indexLines();
+    return tokens;
+}
+
+Token Lexer::make(TokenType type) {
+    return Token(type, start_i, cur_i - start_i);
+}
+
+Token Lexer::make(Token token) {
+    token.offset = start_i;
+    token.length = cur_i - start_i;
+    return token;
+}
+
+Token Lexer::make(const TableEntry& entry) {
+    Token token = make(entry.type);
+    if (entry.type == TokenType::BoolLiteral)
+        token.bool_val = entry.bool_val;
+    return token;
+}
+
+Token Lexer::error(std::string message) {
+    Token token = make(TokenType::Error);
+    token.string_index = result->strings.size();
+    result->strings.push_back(std::move(message));
+    return token;
 }
 
 Token Lexer::getNextToken() {
+    start_i = cur_i;
     if (skip_spaces())
-        return std::move(Token(TokenType::NewLine));
+        return Token(TokenType::NewLine, cur_i, 0);
+    start_i = cur_i;
     if (current() == '\0')
-        return std::move(Token(TokenType::EOI));
+        return make(TokenType::EOI);
     if (isdigit(current()))
         return number();
     if (isalpha(current()) || current() == '_')
@@ -110,28 +97,15 @@ Token Lexer::getNextToken() {
 
 bool Lexer::skip_spaces() {
     bool newline = false;
-    while (current() == ' ' || current() == '\t' || current() == '\n' || current() == '#' || current() == '\r')
+    while (true)
     {
-        if (current() == '#')
-        {
-            move();
-            while (current() != '\n')
-            {
-                if (current() == '\0')
-                    return false;
-                move();
-            }
-            continue;
-        }
-        if (current() == '\n')
-        {
-            newline = true;
-            move();
-            continue;
-        }
-        move();
+        seek(scan::skipBlank(code.data(), cur_i, code_length, newline));
+        if (current() != '#')
+            return newline;
+        seek(scan::findByte(code.data(), cur_i, code_length, '\n'));
+        if (current() == '\0')
+            return false;
     }
-    return newline;
 }
 
 Token Lexer::number()
@@ -151,10 +125,10 @@ Token Lexer::number()
     if (current() == 'f')
     {
         move();
-        return Token::FloatLiteral(v);
+        return make(Token::FloatLiteral(v, 0, 0));
     }
     if (current() != '.') {
-        return Token::IntegerLiteral(v);
+        return make(Token::IntegerLiteral(v, 0, 0));
     }
 
     float x = v;
@@ -170,33 +144,29 @@ Token Lexer::number()
     }
     if (current() == 'f')
         move();
-    return Token::FloatLiteral(x);
+    return make(Token::FloatLiteral(x, 0, 0));
 }
 
 Token Lexer::word()
 {
-    std::string word;
     while (isalpha(current()) || isdigit(current()) || current() == '_')
-    {
-        word += current();
         move();
-    }
-    if (word_to_token.contains(word))
-        return word_to_token[word];
-    return Token::Identifier(word);
+    if (auto keyword = keywords.find(code.substr(start_i, cur_i - start_i)))
+        return make(*keyword);
+    return make(TokenType::Identifier);
 }
 
 Token Lexer::op()
 {
-    if (auto op = std::string() + current() + next(); op_to_token.contains(op))
+    if (auto op = next() != '\0' ? double_ops.find(code.substr(cur_i, 2)) : nullptr)
     {
         move(); move();
-        return op_to_token[op];
+        return make(*op);
     }
-    if (auto op = std::string() + current(); op_to_token.contains(op))
+    if (auto op = (unsigned char)current() < single_ops.size() ? single_ops[(unsigned char)current()] : nullptr)
     {
         move();
-        return op_to_token[op];
+        return make(*op);
     }
     return error_symbol_not_allowed(current());
 }
@@ -205,12 +175,23 @@ Token Lexer::str()
 {
     move();
     std::string str;
+    bool escaped = false;
     while (true)
     {
+        size_t run = cur_i;
+        seek(scan::findStringSpecial(code.data(), cur_i, code_length));
+        if (escaped)
+            str.append(code.substr(run, cur_i - run));
         if (current() == '"')
         {
             move();
-            return Token::StringLiteral(str);
+            Token token = make(TokenType::StringLiteral);
+            if (escaped)
+            {
+                token.string_index = result->strings.size();
+                result->strings.push_back(std::move(str));
+            }
+            return token;
         }
         if (current() == '\0' || current() == '\n')
         {
@@ -219,6 +200,9 @@ Token Lexer::str()
         }
         if (current() == '\\')
         {
+            if (!escaped)
+                str.assign(code.substr(start_i + 1, cur_i - start_i - 1));
+            escaped = true;
             move();
             if (current() == '\\')
                 str += '\\';
@@ -234,22 +218,20 @@ Token Lexer::str()
             move();
             continue;
         }
-        str += current();
-        move();
     }
 }
 
 Token Lexer::error_symbol_not_allowed(char ch)
 {
-    return Token::Error(std::string("This symbol ") + ch + " is not allowed");
+    return error(std::string("This symbol ") + ch + " is not allowed");
 }
 
 Token Lexer::error_expected_end_of_string()
 {
-    return Token::Error("Expected end of string");
+    return error("Expected end of string");
 }
 
 Token Lexer::error_wrong_escape_character()
 {
-    return Token::Error("Wrong escape character");
+    return error("Wrong escape character");
 }
\ No newline at end of file
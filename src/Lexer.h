@@ -1,21 +1,26 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include "token.h"
-#include <map>
-#include <list>
+#include "LexerTables.h"
 
 class Lexer {
-    std::string code;
-    int code_length;
-    int cur_i = 0;
-    int next_i = 1;
-    std::map<std::string, Token> word_to_token;
-    std::map<std::string, Token> op_to_token;
+    std::string_view code;
+    size_t code_length;
+    size_t cur_i = 0;
+    size_t next_i = 1;
+    size_t start_i = 0;
+    TokenList* result = nullptr;
 
     char move();
+    void seek(size_t i);
     char current();
     char next();
 
+    Token make(TokenType type);
+    Token make(Token token);
+    Token make(const TableEntry& entry);
+    Token error(std::string message);
     Token error_symbol_not_allowed(char ch);
     Token error_expected_end_of_string();
     Token error_wrong_escape_character();
@@ -27,7 +32,6 @@ class Lexer {
 
     Token getNextToken();
 public:
-    Lexer();
-    std::list<Token> tokenize(std::string code);
+    Lexer() = default;
+    TokenList tokenize(std::string_view code);
 };
-
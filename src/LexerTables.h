@@ -0,0 +1,129 @@
+#pragma once
+#include "token.h"
+#include <array>
+#include <string_view>
+
+struct TableEntry {
+    std::string_view text;
+    TokenType type;
+    bool bool_val = false;
+};
+
+constexpr std::array keyword_entries = {
+        TableEntry{ "if", TokenType::If },
+        TableEntry{ "else", TokenType::Else },
+        TableEntry{ "while", TokenType::While },
+        TableEntry{ "for", TokenType::For },
+        TableEntry{ "foreach", TokenType::Foreach },
+        TableEntry{ "do", TokenType::Do },
+        TableEntry{ "in", TokenType::In },
+        TableEntry{ "var", TokenType::Var },
+        TableEntry{ "const", TokenType::Const },
+        TableEntry{ "fn", TokenType::Fn },
+        TableEntry{ "return", TokenType::Return },
+        TableEntry{ "true", TokenType::BoolLiteral, true },
+        TableEntry{ "false", TokenType::BoolLiteral, false },
+        TableEntry{ "int", TokenType::IntType },
+        TableEntry{ "float", TokenType::FloatType },
+        TableEntry{ "bool", TokenType::BoolType },
+        TableEntry{ "string", TokenType::StringType },
+};
+
+constexpr std::array single_op_entries = {
+        TableEntry{ ">", TokenType::Greater },
+        TableEntry{ "<", TokenType::Less },
+        TableEntry{ "=", TokenType::Assign },
+        TableEntry{ ";", TokenType::Semicolon },
+        TableEntry{ ":", TokenType::Colon },
+        TableEntry{ "!", TokenType::Not },
+        TableEntry{ ",", TokenType::Comma },
+        TableEntry{ ".", TokenType::Dot },
+        TableEntry{ "+", TokenType::Plus },
+        TableEntry{ "-", TokenType::Minus },
+        TableEntry{ "*", TokenType::Asterisk },
+        TableEntry{ "/", TokenType::Slash },
+        TableEntry{ "\\", TokenType::BackSlash },
+        TableEntry{ "%", TokenType::Percent },
+        TableEntry{ "(", TokenType::LParent },
+        TableEntry{ ")", TokenType::RParent },
+        TableEntry{ "[", TokenType::LBracket },
+        TableEntry{ "]", TokenType::RBracket },
+        TableEntry{ "{", TokenType::LBrace },
+        TableEntry{ "}", TokenType::RBrace },
+};
+
+constexpr std::array double_op_entries = {
+        TableEntry{ "==", TokenType::Equal },
+        TableEntry{ "&&", TokenType::And },
+        TableEntry{ "||", TokenType::Or },
+        TableEntry{ "!=", TokenType::NotEqual },
+        TableEntry{ ">=", TokenType::GreaterEq },
+        TableEntry{ "<=", TokenType::LessEq },
+        TableEntry{ "*=", TokenType::AsteriskEqual },
+        TableEntry{ "/=", TokenType::SlashEqual },
+        TableEntry{ "+=", TokenType::PlusEqual },
+        TableEntry{ "-=", TokenType::MinusEqual },
+        TableEntry{ "//", TokenType::DoubleSlash },
+};
+
+// Collision-free hash table built at compile time: the multiplier is searched
+// until every entry lands in its own slot, so a lookup is one probe and one compare
+template<size_t Bits, size_t N>
+class PerfectHash {
+    static constexpr size_t size = 1 << Bits;
+
+    std::array<TableEntry, N> entries;
+    std::array<uint8_t, size> slots{}; // entry index + 1, 0 for an empty slot
+    uint32_t seed = 0;
+
+    static constexpr uint32_t hash(std::string_view str, uint32_t seed) {
+        uint32_t key = (unsigned char)str[0] | (unsigned char)str[str.size() / 2] << 8
+                | (unsigned char)str[str.size() - 1] << 16 | (uint32_t)str.size() << 24;
+        return (key * seed) >> (32 - Bits);
+    }
+
+    constexpr bool tryBuild(uint32_t candidate) {
+        slots = { };
+        for (size_t i = 0; i < N; i++)
+        {
+            auto slot = hash(entries[i].text, candidate);
+            if (slots[slot] != 0)
+                return false;
+            slots[slot] = i + 1;
+        }
+        seed = candidate;
+        return true;
+    }
+public:
+    constexpr explicit PerfectHash(const std::array<TableEntry, N>& entries) : entries(entries) {
+        static_assert(N < size && N < 255);
+        for (uint32_t candidate = 0x9E3779B1u; !tryBuild(candidate); candidate += 2) { }
+    }
+
+    constexpr const TableEntry* find(std::string_view str) const {
+        if (str.empty())
+            return nullptr;
+        auto index = slots[hash(str, seed)];
+        if (index == 0 || entries[index - 1].text != str)
+            return nullptr;
+        return &entries[index - 1];
+    }
+};
+
+constexpr PerfectHash<5, keyword_entries.size()> keywords(keyword_entries);
+constexpr PerfectHash<5, double_op_entries.size()> double_ops(double_op_entries);
+
+constexpr std::array<const TableEntry*, 128> buildSingleOps() {
+    std::array<const TableEntry*, 128> table{};
+    for (auto& entry : single_op_entries)
+        table[(unsigned char)entry.text[0]] = &entry;
+    return table;
+}
+
+constexpr auto single_ops = buildSingleOps();
+
+static_assert(keywords.find("foreach")->type == TokenType::Foreach);
+static_assert(keywords.find("false")->type == TokenType::BoolLiteral);
+static_assert(keywords.find("fo") == nullptr);
+static_assert(keywords.find("return")->type == TokenType::Return);
+static_assert(double_ops.find("<=")->type == TokenType::LessEq);
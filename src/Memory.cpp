@@ -1,43 +1,27 @@
 #include "Memory.h"
 #include <iostream>
-#include <utility>
-#include "values.h"
 
-ValueID Memory::generateRandomID() {
-    static ValueID id = 0;
-    id++;
-    return id;
+void Memory::pushFrame(size_t size) {
+    frames.push_back(stack.size());
+    stack.resize(stack.size() + size);
 }
 
-ValueID Memory::newOp(std::shared_ptr<Value> val) {
-    auto id = generateRandomID();
-    while (mem.contains(id))
-        id = generateRandomID();
-    mem[id] = std::move(val);
-    return id;
-}
-
-void Memory::deleteOP(ValueID id) {
-    if (mem.contains(id))
-        mem.erase(id);
-    else
-        throw std::exception("Not found in memory");
-}
-
-std::shared_ptr<Value> Memory::get(ValueID id) {
-    if (mem.contains(id))
-        return mem[id];
-    else
-        throw std::exception("Not found in memory");
-}
-
-void Memory::set(ValueID id, std::shared_ptr<Value> val) {
-    mem[id] = std::move(val);
+void Memory::popFrame() {
+    if (frames.empty())
+        throw std::exception("No frame to pop");
+    stack.resize(frames.back());
+    frames.pop_back();
 }
 
 void Memory::print() {
     std::cout << "Memory:" << "\n";
-    for (auto e : mem) {
-        std::cout << e.first << '\t' << e.second->ToFloat() << '\n';
+    for (size_t depth = 0; depth < frames.size(); depth++)
+    {
+        size_t begin = frames[frames.size() - 1 - depth];
+        size_t end = depth == 0 ? stack.size() : frames[frames.size() - depth];
+        for (size_t slot = 0; slot < end - begin; slot++)
+        {
+            std::cout << depth << ':' << slot << '\t' << stack[begin + slot] << '\n';
+        }
     }
-}
\ No newline at end of file
+}
@@ -1,17 +1,22 @@
 #pragma once
-#include <unordered_map>
-#include <memory>
-class Value;
-
-using ValueID = unsigned long long;
+#include <vector>
+#include <cstdint>
+#include "values.h"
 
 class Memory {
-    std::unordered_map<ValueID, std::shared_ptr<Value>> mem;
-    ValueID generateRandomID();
+    std::vector<Value> stack;
+    std::vector<size_t> frames;
 public:
-    ValueID newOp(std::shared_ptr<Value> val);
-    void deleteOP(ValueID id);
-    std::shared_ptr<Value> get(ValueID id);
-    void set(ValueID id, std::shared_ptr<Value> val);
+    // Depth of the script's outermost frame, used by functions to reach global variables
+    static constexpr uint32_t global_depth = UINT32_MAX;
+
+    void pushFrame(size_t size);
+    void popFrame();
+
+    Value& get(uint32_t depth, uint32_t slot) {
+        size_t frame = depth == global_depth ? 0 : frames.size() - 1 - depth;
+        return stack[frames[frame] + slot];
+    }
+
     void print();
-};
\ No newline at end of file
+};
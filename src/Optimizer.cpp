@@ -0,0 +1,186 @@
+#include "Optimizer.h"
+
+Stmt* Optimizer::optimize(Stmt* ast) {
+    return stmt(ast);
+}
+
+std::optional<Value> Optimizer::constant(Expr* ast) {
+    switch (ast->expr_type) {
+        case ExprType::IntLiteral:
+            return Value::Int(dynamic_cast<IntLiteralExpr*>(ast)->value);
+        case ExprType::FloatLiteral:
+            return Value::Float(dynamic_cast<FloatLiteralExpr*>(ast)->value);
+        case ExprType::BoolLiteral:
+            return Value::Bool(dynamic_cast<BoolLiteralExpr*>(ast)->value);
+        case ExprType::StringLiteral:
+            return Value::String(dynamic_cast<StringLiteralExpr*>(ast)->value);
+        default:
+            return std::nullopt;
+    }
+}
+
+Expr* Optimizer::literal(const Value& value, const Expr* at) {
+    Expr* expr;
+    switch (value.type) {
+        case ValueType::Int:
+            expr = arena.make<IntLiteralExpr>(value.int_val);
+            break;
+        case ValueType::Float:
+            expr = arena.make<FloatLiteralExpr>(value.float_val);
+            break;
+        case ValueType::Bool:
+            expr = arena.make<BoolLiteralExpr>(value.bool_val);
+            break;
+        case ValueType::String:
+            expr = arena.make<StringLiteralExpr>(arena.copy(*value.str_val));
+            break;
+        default:
+            return nullptr;
+    }
+    expr->line = at->line;
+    expr->column = at->column;
+    return expr;
+}
+
+Expr* Optimizer::fold(Expr* ast) {
+    switch (ast->expr_type) {
+        case ExprType::List: {
+            for (auto& item : dynamic_cast<ListExpr*>(ast)->items)
+                item = fold(item);
+            return ast;
+        }
+        case ExprType::FnCall: {
+            auto e = dynamic_cast<FnCallExpr*>(ast);
+            for (auto& arg : e->args)
+                arg = fold(arg);
+            for (auto& keyword : e->keywords)
+                keyword.value = fold(keyword.value);
+            return ast;
+        }
+        default:
+            break;
+    }
+
+    if (auto e = dynamic_cast<BinaryOpExpr*>(ast))
+    {
+        e->left_expr = fold(e->left_expr);
+        e->right_expr = fold(e->right_expr);
+        auto left = constant(e->left_expr);
+        auto right = constant(e->right_expr);
+        if (!left || !right)
+            return ast;
+        // Integer % 0 and INT_MIN % -1 trap, leave them to fail at runtime as before
+        if (e->expr_type == ExprType::Mod && right->IsInteger() && (right->ToInt() == 0 || right->ToInt() == -1))
+            return ast;
+        try {
+            auto folded = literal(interpreter.DoBinOp(*left, *right, e->expr_type), ast);
+            return folded != nullptr ? folded : ast;
+        }
+        catch (std::exception&) {
+            return ast; // unsupported operand types are still reported when the expression runs
+        }
+    }
+
+    if (auto e = dynamic_cast<UnaryOpExpr*>(ast))
+    {
+        e->expr = fold(e->expr);
+        auto value = constant(e->expr);
+        if (!value)
+            return ast;
+        if (e->expr_type == ExprType::ToString)
+            return literal(Value::String(value->ToString()), ast);
+        if (!value->IsNumeric())
+            return ast;
+        switch (e->expr_type) {
+            case ExprType::Neg:
+                return literal(value->IsInteger() ? Value::Int(-value->ToInt()) : Value::Float(-value->ToFloat()), ast);
+            case ExprType::Not:
+                return literal(Value::Bool(!value->ToBool()), ast);
+            case ExprType::ToBool:
+                return literal(Value::Bool(value->ToBool()), ast);
+            case ExprType::ToInt:
+                return literal(Value::Int(value->ToInt()), ast);
+            case ExprType::ToFloat:
+                return literal(Value::Float(value->ToFloat()), ast);
+            default:
+                return ast;
+        }
+    }
+    return ast;
+}
+
+void Optimizer::block(BlockStmt* ast) {
+    size_t count = 0;
+    for (auto s : ast->stmts)
+    {
+        s = stmt(s);
+        if (s != nullptr)
+            ast->stmts[count++] = s;
+    }
+    ast->stmts.resize(count);
+}
+
+// Returns nullptr for statements that can be dropped
+Stmt* Optimizer::stmt(Stmt* ast) {
+    switch (ast->stmt_type) {
+        case StmtType::Declaration: {
+            auto s = dynamic_cast<DeclarationStmt*>(ast);
+            s->right = fold(s->right);
+            return ast;
+        }
+        case StmtType::Assignment: {
+            auto s = dynamic_cast<AssignmentStmt*>(ast);
+            s->right = fold(s->right);
+            return ast;
+        }
+        case StmtType::Expression: {
+            auto s = dynamic_cast<ExpressionStmt*>(ast);
+            s->expr = fold(s->expr);
+            return ast;
+        }
+        case StmtType::If: {
+            auto s = dynamic_cast<IfStmt*>(ast);
+            s->cond = fold(s->cond);
+            block(s->action);
+            block(s->else_action);
+            auto cond = constant(s->cond);
+            if (cond && cond->IsNumeric())
+                return cond->ToBool() ? s->action : s->else_action;
+            return ast;
+        }
+        case StmtType::While: {
+            auto s = dynamic_cast<WhileStmt*>(ast);
+            s->cond = fold(s->cond);
+            block(s->action);
+            auto cond = constant(s->cond);
+            if (cond && cond->IsNumeric() && !cond->ToBool())
+                return nullptr;
+            return ast;
+        }
+        case StmtType::DoWhile: {
+            auto s = dynamic_cast<DoWhileStmt*>(ast);
+            s->cond = fold(s->cond);
+            block(s->action);
+            auto cond = constant(s->cond);
+            if (cond && cond->IsNumeric() && !cond->ToBool())
+                return s->action;
+            return ast;
+        }
+        case StmtType::Block:
+            block(dynamic_cast<BlockStmt*>(ast));
+            return ast;
+        case StmtType::Function:
+            block(dynamic_cast<FunctionStmt*>(ast)->body);
+            return ast;
+        case StmtType::Return: {
+            auto s = dynamic_cast<ReturnStmt*>(ast);
+            if (s->value != nullptr)
+                s->value = fold(s->value);
+            return ast;
+        }
+        case StmtType::None:
+            return nullptr;
+        default:
+            return ast;
+    }
+}
@@ -0,0 +1,23 @@
+#pragma once
+#include "AST.h"
+#include "Arena.h"
+#include "Interpreter.h"
+#include <optional>
+
+// Runs between the parser and evaluation: folds constant expressions with the interpreter's own
+// operations, replaces if statements with constant conditions by the branch that is taken
+// and drops empty statements
+class Optimizer {
+    Arena& arena;
+    Interpreter& interpreter;
+
+    std::optional<Value> constant(Expr* ast);
+    Expr* literal(const Value& value, const Expr* at);
+    Expr* fold(Expr* ast);
+    Stmt* stmt(Stmt* ast);
+    void block(BlockStmt* ast);
+public:
+    Optimizer(Arena& arena, Interpreter& interpreter) : arena(arena), interpreter(interpreter) { }
+
+    Stmt* optimize(Stmt* ast);
+};
@@ -0,0 +1,161 @@
+#include "OutputCache.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <vector>
+#ifdef __linux__
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    // Reflink, then an in-kernel copy, then a plain copy
+    bool cloneFile(const std::filesystem::path& from, const std::filesystem::path& to) {
+#ifdef __linux__
+        int in = open(from.c_str(), O_RDONLY | O_CLOEXEC);
+        if (in < 0)
+            return false;
+        struct stat info;
+        int out = fstat(in, &info) == 0 ? open(to.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, info.st_mode & 0777) : -1;
+        bool done = false;
+        if (out >= 0)
+        {
+            done = ioctl(out, FICLONE, in) == 0;
+            for (off_t left = info.st_size; !done; )
+            {
+                ssize_t size = copy_file_range(in, nullptr, out, nullptr, left, 0);
+                if (size <= 0)
+                    break;
+                left -= size;
+                done = left == 0;
+            }
+            done = done || info.st_size == 0;
+            close(out);
+        }
+        close(in);
+        if (done)
+            return true;
+#endif
+        std::error_code error;
+        std::filesystem::copy_file(from, to, std::filesystem::copy_options::overwrite_existing, error);
+        return !error;
+    }
+
+    std::string hex(uint64_t value) {
+        std::ostringstream out;
+        out << std::hex << std::setw(16) << std::setfill('0') << value;
+        return out.str();
+    }
+}
+
+std::filesystem::path OutputCache::defaultDirectory() {
+    if (auto path = std::getenv("BMAKE_CACHE_DIR"))
+        return path;
+    if (auto path = std::getenv("XDG_CACHE_HOME"))
+        return std::filesystem::path(path) / "bmake";
+    if (auto path = std::getenv("LOCALAPPDATA"))
+        return std::filesystem::path(path) / "bmake";
+    if (auto path = std::getenv("HOME"))
+        return std::filesystem::path(path) / ".cache" / "bmake";
+    return std::filesystem::temp_directory_path() / "bmake-cache";
+}
+
+std::filesystem::path OutputCache::entryPath(uint64_t key) {
+    auto name = hex(key);
+    return directory / "objects" / name.substr(0, 2) / name;
+}
+
+bool OutputCache::restore(uint64_t key, const Rule& rule) {
+    auto entry = entryPath(key);
+    std::error_code error;
+    for (size_t i = 0; i < rule.outputs.size(); i++)
+        if (!std::filesystem::is_regular_file(entry / std::to_string(i), error))
+            return false;
+    for (size_t i = 0; i < rule.outputs.size(); i++)
+    {
+        auto target = rule.directory / rule.outputs[i];
+        std::filesystem::create_directories(target.parent_path(), error);
+        std::filesystem::remove(target, error);
+        // An entry evicted by another build in the meantime just means running the rule
+        if (!cloneFile(entry / std::to_string(i), target))
+            return false;
+    }
+    // The entry's time is its last use
+    std::filesystem::last_write_time(entry, std::filesystem::file_time_type::clock::now(), error);
+    return true;
+}
+
+void OutputCache::store(uint64_t key, const Rule& rule) {
+    auto entry = entryPath(key);
+    std::error_code error;
+    if (rule.outputs.empty() || std::filesystem::exists(entry, error))
+        return;
+    // Entries are filled under a private name and renamed, so a reader never sees half of one
+    std::ostringstream name;
+    name << hex(key) << '.' << std::this_thread::get_id() << '.' << std::chrono::steady_clock::now().time_since_epoch().count();
+    auto temp = directory / "tmp" / name.str();
+    if (!std::filesystem::create_directories(temp, error))
+        return;
+    uint64_t size = 0;
+    for (size_t i = 0; i < rule.outputs.size(); i++)
+    {
+        auto file = temp / std::to_string(i);
+        if (!cloneFile(rule.directory / rule.outputs[i], file))
+        {
+            std::filesystem::remove_all(temp, error);
+            return;
+        }
+        size += std::filesystem::file_size(file, error);
+    }
+    std::filesystem::create_directories(entry.parent_path(), error);
+    std::filesystem::rename(temp, entry, error);
+    if (error)
+        std::filesystem::remove_all(temp, error);
+    else
+        stored += size;
+}
+
+void OutputCache::trim() {
+    if (stored == 0)
+        return;
+    stored = 0;
+    struct Entry {
+        std::filesystem::path path;
+        std::filesystem::file_time_type time;
+        uint64_t size;
+    };
+    std::vector<Entry> entries;
+    uint64_t total = 0;
+    std::error_code error;
+    for (auto it = std::filesystem::recursive_directory_iterator(directory / "objects", error);
+         !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error))
+    {
+        std::error_code ignored;
+        if (it.depth() != 1 || !it->is_directory(ignored))
+            continue;
+        Entry entry = { it->path(), it->last_write_time(ignored), 0 };
+        for (auto& file : std::filesystem::directory_iterator(it->path(), ignored))
+            entry.size += file.file_size(ignored);
+        total += entry.size;
+        entries.push_back(std::move(entry));
+        it.disable_recursion_pending();
+    }
+    if (total <= capacity)
+        return;
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.time < b.time; });
+    for (auto& entry : entries)
+    {
+        if (total <= capacity)
+            break;
+        std::filesystem::remove_all(entry.path, error);
+        // Fails while the prefix directory still holds other entries
+        std::filesystem::remove(entry.path.parent_path(), error);
+        total -= entry.size;
+    }
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include "BuildGraph.h"
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+
+// Content-addressable store of rule outputs shared by every checkout of a user. An entry is keyed by the
+// hash of the command, the output names and the input contents, and holds one file per output.
+// Outputs are restored as reflinks where the filesystem supports them and copied otherwise; hardlinks
+// aren't used because a rule editing its output in place would corrupt the shared entry.
+class OutputCache {
+    std::filesystem::path directory;
+    uint64_t capacity;
+    std::atomic<uint64_t> stored = 0;
+
+    std::filesystem::path entryPath(uint64_t key);
+public:
+    OutputCache(std::filesystem::path directory, uint64_t capacity) : directory(std::move(directory)), capacity(capacity) { }
+
+    // Copies the cached outputs of the rule into place, false if there is no complete entry
+    bool restore(uint64_t key, const Rule& rule);
+    void store(uint64_t key, const Rule& rule);
+    // Evicts least recently used entries until the cache fits its capacity
+    void trim();
+
+    // $BMAKE_CACHE_DIR, otherwise a bmake directory in the user's cache directory
+    static std::filesystem::path defaultDirectory();
+};
@@ -10,7 +10,7 @@ void Parser::move() {
         return;
     if (current().type == TokenType::Error)
     {
-        std::cout << current().string_val.value() << '\n';
+        std::cout << tokens->text(current()) << '\n';
         return;
     }
     it++;
@@ -22,7 +22,7 @@ bool Parser::match(TokenType type) {
         return true;
     }
     else if (current().type == TokenType::Error)
-        std::cout << current().string_val.value() << '\n';
+        std::cout << tokens->text(current()) << '\n';
     return false;
 }
 
@@ -41,9 +41,9 @@ void Parser::move_skip() {
     move();
 }
 
-std::unique_ptr<Stmt> Parser::getAST(std::list<Token>& tokens) {
+Stmt* Parser::getAST(const TokenList& tokens) {
     this->tokens = &tokens;
-    it = tokens.begin();
+    it = tokens.tokens.begin();
 
     //if (auto t_last = tokens.end(); t_last->type == TokenType::Error)
     //{
@@ -53,8 +53,10 @@ std::unique_ptr<Stmt> Parser::getAST(std::list<Token>& tokens) {
         return stmtBlock();
 }
 
-std::unique_ptr<BlockStmt> Parser::stmtBlock() {
-    auto block = std::make_unique<BlockStmt>();
+BlockStmt* Parser::stmtBlock() {
+    // Braced blocks are positioned at their '{' rather than at their first statement
+    bool braced = it != tokens->tokens.begin() && std::prev(it)->type == TokenType::LBrace;
+    auto block = make<BlockStmt>(braced ? *std::prev(it) : current(), arena.memory());
     while (true)
     {
         skipStmtEnd();
@@ -64,15 +66,19 @@ std::unique_ptr<BlockStmt> Parser::stmtBlock() {
             block->add(ifStmt());
         else if (current().type == TokenType::While)
             block->add(whileStmt());
+        else if (current().type == TokenType::Fn)
+            block->add(functionStmt());
+        else if (current().type == TokenType::Return)
+            block->add(returnStmt());
         else if (current().type == TokenType::EOI || current().type == TokenType::RBrace)
             break;
         else
             block->add(assignment());
     }
-    return std::move(block);
+    return block;
 }
 
-std::unique_ptr<Stmt> Parser::stmt() {
+Stmt* Parser::stmt() {
     skipStmtEnd();
     if (current().type == TokenType::Var)
         return declaration();
@@ -80,15 +86,18 @@ std::unique_ptr<Stmt> Parser::stmt() {
         return ifStmt();
     if (current().type == TokenType::While)
         return whileStmt();
+    if (current().type == TokenType::Return)
+        return returnStmt();
     return assignment();
 }
 
-std::unique_ptr<Stmt> Parser::ifStmt() {
+Stmt* Parser::ifStmt() {
+    auto start = current();
     match(TokenType::If);
     skipNewLine();
     auto cond = boolExpr();
-    std::unique_ptr<BlockStmt> body;
-    std::unique_ptr<BlockStmt> else_body;
+    BlockStmt* body;
+    BlockStmt* else_body;
     if (current_skip().type == TokenType::LBrace)
     {
         move();
@@ -96,7 +105,7 @@ std::unique_ptr<Stmt> Parser::ifStmt() {
         match(TokenType::RBrace);
     }
     else {
-        body = std::make_unique<BlockStmt>();
+        body = make<BlockStmt>(current(), arena.memory());
         body->add(stmt());
     }
     if (current_skip().type == TokenType::Else)
@@ -109,22 +118,23 @@ std::unique_ptr<Stmt> Parser::ifStmt() {
             match(TokenType::RBrace);
         }
         else {
-            else_body = std::make_unique<BlockStmt>();
+            else_body = make<BlockStmt>(current(), arena.memory());
             else_body->add(stmt());
         }
     }
     else {
-        else_body = std::make_unique<BlockStmt>();
-        else_body->add(std::make_unique<NoneStmt>());
+        else_body = make<BlockStmt>(current(), arena.memory());
+        else_body->add(make<NoneStmt>(current()));
     }
-    return std::make_unique<IfStmt>(std::move(cond), std::move(body), std::move(else_body));
+    return make<IfStmt>(start, cond, body, else_body);
 }
 
-std::unique_ptr<Stmt> Parser::whileStmt() {
+Stmt* Parser::whileStmt() {
+    auto start = current();
     match(TokenType::While);
     skipNewLine();
     auto cond = boolExpr();
-    std::unique_ptr<BlockStmt> body;
+    BlockStmt* body;
     if (current_skip().type == TokenType::LBrace)
     {
         move();
@@ -132,15 +142,16 @@ std::unique_ptr<Stmt> Parser::whileStmt() {
         match(TokenType::RBrace);
     }
     else {
-        body = std::make_unique<BlockStmt>();
+        body = make<BlockStmt>(current(), arena.memory());
         body->add(stmt());
     }
-    return std::make_unique<WhileStmt>(std::move(cond), std::move(body));
+    return make<WhileStmt>(start, cond, body);
 }
 
-std::unique_ptr<Stmt> Parser::doWhileStmt() {
+Stmt* Parser::doWhileStmt() {
+    auto start = current();
     match(TokenType::Do);
-    std::unique_ptr<BlockStmt> body;
+    BlockStmt* body;
     if (current_skip().type == TokenType::LBrace)
     {
         move();
@@ -148,37 +159,90 @@ std::unique_ptr<Stmt> Parser::doWhileStmt() {
         match(TokenType::RBrace);
     }
     else {
-        body = std::make_unique<BlockStmt>();
+        body = make<BlockStmt>(current(), arena.memory());
         body->add(stmt());
     }
     match(TokenType::While);
     auto cond = boolExpr();
     stmtEnd();
-    return std::make_unique<DoWhileStmt>(std::move(cond), std::move(body));
+    return make<DoWhileStmt>(start, cond, body);
 }
 
+Stmt* Parser::functionStmt() {
+    auto start = current();
+    match(TokenType::Fn);
+    auto name = identifierExpr()->id;
+    if (!match(TokenType::LParent))
+        throw std::exception("Expected '(' after function name");
+    std::pmr::vector<std::string_view> params(arena.memory());
+    if (!match_skip(TokenType::RParent))
+    {
+        while (true)
+        {
+            skipNewLine();
+            params.push_back(identifierExpr()->id);
+            if (match_skip(TokenType::RParent))
+                break;
+            if (!match(TokenType::Comma))
+                throw std::exception("Expected ',' or ')' in parameter list");
+        }
+    }
+    if (!match_skip(TokenType::LBrace))
+        throw std::exception("Expected function body");
+    auto body = stmtBlock();
+    match(TokenType::RBrace);
+    auto function = make<FunctionStmt>(start, name, body, arena.memory());
+    function->params = std::move(params);
+    return function;
+}
 
+Stmt* Parser::returnStmt() {
+    auto start = current();
+    match(TokenType::Return);
+    if (current().type == TokenType::Semicolon || current().type == TokenType::NewLine
+        || current().type == TokenType::EOI || current().type == TokenType::RBrace)
+    {
+        if (current().type != TokenType::RBrace)
+            stmtEnd();
+        return make<ReturnStmt>(start, nullptr);
+    }
+    Expr* value = boolExpr();
+    if (current().type == TokenType::Comma)
+    {
+        // return a, b gives back a list
+        auto list = make<ListExpr>(value, arena.memory());
+        list->add(value);
+        while (match(TokenType::Comma))
+            list->add(boolExpr());
+        value = list;
+    }
+    if (current().type != TokenType::RBrace)
+        stmtEnd();
+    return make<ReturnStmt>(start, value);
+}
 
-std::unique_ptr<Stmt> Parser::declaration() {
+Stmt* Parser::declaration() {
+    auto start = current();
     match(TokenType::Var);
-    std::unique_ptr<IdentifierExpr> expr = identifierExpr();
+    IdentifierExpr* expr = identifierExpr();
     match(TokenType::Assign);
-    std::unique_ptr<Expr> right_expr = boolExpr();
+    Expr* right_expr = boolExpr();
     stmtEnd();
-    return std::make_unique<DeclarationStmt>(std::move(expr), std::move(right_expr));
+    return make<DeclarationStmt>(start, expr, right_expr);
 }
 
-std::unique_ptr<Stmt> Parser::assignment() {
-    std::unique_ptr<Expr> left_expr = boolExpr();
+Stmt* Parser::assignment() {
+    auto start = current();
+    Expr* left_expr = boolExpr();
     if (current().type == TokenType::Assign)
     {
         move();
-        std::unique_ptr<Expr> right_expr = boolExpr();
+        Expr* right_expr = boolExpr();
         stmtEnd();
-        return std::make_unique<AssignmentStmt>(std::move(left_expr), std::move(right_expr));
+        return make<AssignmentStmt>(start, left_expr, right_expr);
     }
     stmtEnd();
-    return std::make_unique<ExpressionStmt>(std::move(left_expr));
+    return make<ExpressionStmt>(start, left_expr);
 }
 
 void Parser::stmtEnd() {
@@ -211,205 +275,248 @@ void Parser::skipNewLine() {
     }
 }
 
-std::unique_ptr<IdentifierExpr> Parser::identifierExpr() {
+IdentifierExpr* Parser::identifierExpr() {
     if (current().type != TokenType::Identifier)
         std::cout << "Wrong token type";
-    auto str = current().string_val.value();
+    auto at = current();
     move();
-    return std::make_unique<IdentifierExpr>(str);
+    return make<IdentifierExpr>(at, arena.copy(tokens->text(at)));
 }
 
-std::unique_ptr<Expr> Parser::boolExpr() {
+Expr* Parser::boolExpr() {
     auto left = join();
     if (current().type == TokenType::Or)
     {
         move();
         auto right = boolExpr();
-        return std::make_unique<BinaryOpExpr>(std::move(left), std::move(right), ExprType::Or);
+        return binary(left, right, ExprType::Or);
     }
-    return std::move(left);
+    return left;
 }
 
-std::unique_ptr<Expr> Parser::join() {
+Expr* Parser::join() {
     auto left = eq();
     if (current().type == TokenType::And)
     {
         move();
         auto right = join();
-        return std::make_unique<BinaryOpExpr>(std::move(left), std::move(right), ExprType::And);
+        return binary(left, right, ExprType::And);
     }
-    return std::move(left);
+    return left;
 }
 
-std::unique_ptr<Expr> Parser::eq() {
+Expr* Parser::eq() {
     auto left = rel();
     if (current().type == TokenType::Equal)
     {
         move();
         auto right = eq();
-        return std::make_unique<BinaryOpExpr>(std::move(left), std::move(right), ExprType::Eq);
+        return binary(left, right, ExprType::Eq);
     }
     if (current().type == TokenType::NotEqual)
     {
         move();
         auto right = eq();
-        return std::make_unique<BinaryOpExpr>(std::move(left), std::move(right), ExprType::NotEq);
+        return binary(left, right, ExprType::NotEq);
     }
-    return std::move(left);
+    return left;
 }
 
-std::unique_ptr<Expr> Parser::rel() {
+Expr* Parser::rel() {
     auto left = expr();
     if (current().type == TokenType::Greater)
     {
         move();
         auto right = rel();
-        return std::make_unique<BinaryOpExpr>(std::move(left), std::move(right), ExprType::Greater);
+        return binary(left, right, ExprType::Greater);
     }
     if (current().type == TokenType::Less)
     {
         move();
         auto right = rel();
-        return std::make_unique<BinaryOpExpr>(std::move(left), std::move(right), ExprType::Less);
+        return binary(left, right, ExprType::Less);
     }
     if (current().type == TokenType::GreaterEq)
     {
         move();
         auto right = rel();
-        return std::make_unique<BinaryOpExpr>(std::move(left), std::move(right), ExprType::GreaterEq);
+        return binary(left, right, ExprType::GreaterEq);
     }
     if (current().type == TokenType::LessEq)
     {
         move();
         auto right = rel();
-        return std::make_unique<BinaryOpExpr>(std::move(left), std::move(right), ExprType::LessEq);
+        return binary(left, right, ExprType::LessEq);
     }
-    return std::move(left);
+    return left;
 }
 
-std::unique_ptr<Expr> Parser::expr() {
+Expr* Parser::expr() {
     auto left = term();
     if (current().type == TokenType::Plus)
     {
         move();
         auto right = expr();
-        return std::make_unique<BinaryOpExpr>(std::move(left), std::move(right), ExprType::Add);
+        return binary(left, right, ExprType::Add);
     }
     if (current().type == TokenType::Minus)
     {
         move();
         auto right = expr();
-        return std::make_unique<BinaryOpExpr>(std::move(left), std::move(right), ExprType::Sub);
+        return binary(left, right, ExprType::Sub);
     }
-    return std::move(left);
+    return left;
 }
 
-std::unique_ptr<Expr> Parser::term() {
+Expr* Parser::term() {
     auto left = unary();
     if (current().type == TokenType::Asterisk)
     {
         move();
         auto right = term();
-        return std::make_unique<BinaryOpExpr>(std::move(left), std::move(right), ExprType::Mul);
+        return binary(left, right, ExprType::Mul);
     }
     if (current().type == TokenType::Slash)
     {
         move();
         auto right = term();
-        return std::make_unique<BinaryOpExpr>(std::move(left), std::move(right), ExprType::Div);
+        return binary(left, right, ExprType::Div);
     }
     if (current().type == TokenType::DoubleSlash)
     {
         move();
         auto right = term();
-        return std::make_unique<BinaryOpExpr>(std::move(left), std::move(right), ExprType::IntDiv);
+        return binary(left, right, ExprType::IntDiv);
     }
     if (current().type == TokenType::Percent)
     {
         move();
         auto right = term();
-        return std::make_unique<BinaryOpExpr>(std::move(left), std::move(right), ExprType::Mod);
+        return binary(left, right, ExprType::Mod);
     }
-    return std::move(left);
+    return left;
 }
 
-std::unique_ptr<Expr> Parser::unary() {
+Expr* Parser::unary() {
+    auto start = current();
     if (current().type == TokenType::Not)
     {
         move();
         auto expr = unary();
-        return std::make_unique<UnaryOpExpr>(std::move(expr), ExprType::Not);
+        return make<UnaryOpExpr>(start, expr, ExprType::Not);
     }
     if (current().type == TokenType::Minus)
     {
         move();
         auto expr = unary();
-        return std::make_unique<UnaryOpExpr>(std::move(expr), ExprType::Neg);
+        return make<UnaryOpExpr>(start, expr, ExprType::Neg);
     }
     return primary();
 }
 
-std::unique_ptr<Expr> Parser::primary() {
+Expr* Parser::primary() {
     auto cur = current();
     move();
     if (cur.type == TokenType::FloatLiteral)
-        return std::make_unique<FloatLiteralExpr>(cur.float_val.value());
+        return make<FloatLiteralExpr>(cur, cur.float_val);
     if (cur.type == TokenType::StringLiteral)
-        return std::make_unique<StringLiteralExpr>(cur.string_val.value());
+        return make<StringLiteralExpr>(cur, arena.copy(tokens->text(cur)));
     if (cur.type == TokenType::IntegerLiteral)
-        return std::make_unique<IntLiteralExpr>(cur.int_val.value());
+        return make<IntLiteralExpr>(cur, cur.int_val);
     if (cur.type == TokenType::BoolLiteral)
-        return std::make_unique<BoolLiteralExpr>(cur.bool_val.value());
+        return make<BoolLiteralExpr>(cur, cur.bool_val);
 
     if (cur.type == TokenType::BoolType)
     {
         match(TokenType::LParent);
         auto expr = boolExpr();
         match(TokenType::RParent);
-        return std::make_unique<UnaryOpExpr>(std::move(expr), ExprType::ToBool);
+        return make<UnaryOpExpr>(cur, expr, ExprType::ToBool);
     }
     if (cur.type == TokenType::StringType)
     {
         match(TokenType::LParent);
         auto expr = boolExpr();
         match(TokenType::RParent);
-        return std::make_unique<UnaryOpExpr>(std::move(expr), ExprType::ToString);
+        return make<UnaryOpExpr>(cur, expr, ExprType::ToString);
     }
     if (cur.type == TokenType::IntType)
     {
         match(TokenType::LParent);
         auto expr = boolExpr();
         match(TokenType::RParent);
-        return std::make_unique<UnaryOpExpr>(std::move(expr), ExprType::ToInt);
+        return make<UnaryOpExpr>(cur, expr, ExprType::ToInt);
     }
     if (cur.type == TokenType::FloatType)
     {
         match(TokenType::LParent);
         auto expr = boolExpr();
         match(TokenType::RParent);
-        return std::make_unique<UnaryOpExpr>(std::move(expr), ExprType::ToFloat);
+        return make<UnaryOpExpr>(cur, expr, ExprType::ToFloat);
     }
 
     if (cur.type == TokenType::LParent)
     {
         auto expr = boolExpr();
         match(TokenType::RParent);
-        return std::move(expr);
+        return expr;
     }
 
+    if (cur.type == TokenType::LBracket)
+        return listExpr(cur);
+
     if (cur.type == TokenType::Identifier)
     {
-        auto expr = std::make_unique<IdentifierExpr>(cur.string_val.value());
-        //while (true)
-        //{
-        //    if (current().type == TokenType::LParent)
-        //    {
-        //        move();
-        //
-        //    }
-        //    break;
-        //}
-        return std::move(expr);
+        auto expr = make<IdentifierExpr>(cur, arena.copy(tokens->text(cur)));
+        if (current().type == TokenType::LParent)
+        {
+            move();
+            return fnCall(expr);
+        }
+        return expr;
     }
     throw std::exception("Unknown token");
+}
+
+Expr* Parser::fnCall(Expr* id_expr) {
+    auto call = make<FnCallExpr>(id_expr, id_expr, arena.memory());
+    if (match_skip(TokenType::RParent))
+        return call;
+    while (true)
+    {
+        skipNewLine();
+        if (current().type == TokenType::Identifier && (it + 1)->type == TokenType::Assign)
+        {
+            auto name = tokens->text(current());
+            it += 2;
+            call->addKeyword(arena.copy(name), boolExpr());
+        }
+        else
+            call->add(boolExpr());
+        if (match_skip(TokenType::RParent))
+            break;
+        if (!match(TokenType::Comma))
+            throw std::exception("Expected ',' or ')' in function call");
+    }
+    return call;
+}
+
+Expr* Parser::listExpr(const Token& at) {
+    auto list = make<ListExpr>(at, arena.memory());
+    if (match_skip(TokenType::RBracket))
+        return list;
+    while (true)
+    {
+        skipNewLine();
+        list->add(boolExpr());
+        if (match_skip(TokenType::RBracket))
+            break;
+        if (!match(TokenType::Comma))
+            throw std::exception("Expected ',' or ']' in list");
+    }
+    return list;
+}
+
+Expr* Parser::binary(Expr* left, Expr* right, ExprType type) {
+    return make<BinaryOpExpr>(left, left, right, type);
 }
\ No newline at end of file
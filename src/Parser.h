@@ -1,10 +1,34 @@
 #pragma once
 #include "Lexer.h"
 #include "AST.h"
+#include "Arena.h"
 
 class Parser {
-    std::list<Token>* tokens = nullptr;
-    std::list<Token>::iterator it;
+    Arena& arena;
+    const TokenList* tokens = nullptr;
+    size_t nodes = 0;
+
+    // Allocates a node positioned at the given token
+    template<class T, class... Args>
+    T* make(const Token& at, Args&&... args) {
+        auto node = arena.make<T>(std::forward<Args>(args)...);
+        tokens->position(at.offset, node->line, node->column);
+        nodes++;
+        return node;
+    }
+
+    // Allocates a node at the position of another one
+    template<class T, class... Args>
+    T* make(const Node* at, Args&&... args) {
+        auto node = arena.make<T>(std::forward<Args>(args)...);
+        node->line = at->line;
+        node->column = at->column;
+        nodes++;
+        return node;
+    }
+
+    Expr* binary(Expr* left, Expr* right, ExprType type);
+    std::vector<Token>::const_iterator it;
     void move();
     Token current();
     bool match(TokenType type);
@@ -16,25 +40,31 @@ class Parser {
     void skipStmtEnd();
     void skipNewLine();
 
-    std::unique_ptr<Stmt> stmt();
-    std::unique_ptr<Stmt> ifStmt();
-    std::unique_ptr<Stmt> whileStmt();
-    std::unique_ptr<Stmt> doWhileStmt();
-    //std::unique_ptr<Stmt> ifStmt();
-    std::unique_ptr<BlockStmt> stmtBlock();
-    std::unique_ptr<Stmt> declaration();
-    std::unique_ptr<Stmt> assignment();
-    std::unique_ptr<IdentifierExpr> identifierExpr();
-    std::unique_ptr<Expr> boolExpr();
-    std::unique_ptr<Expr> join();
-    std::unique_ptr<Expr> eq();
-    std::unique_ptr<Expr> rel();
-    std::unique_ptr<Expr> expr();
-    std::unique_ptr<Expr> term();
-    std::unique_ptr<Expr> unary();
-    std::unique_ptr<Expr> primary();
+    Stmt* stmt();
+    Stmt* ifStmt();
+    Stmt* whileStmt();
+    Stmt* doWhileStmt();
+    Stmt* functionStmt();
+    Stmt* returnStmt();
+    //Stmt* ifStmt();
+    BlockStmt* stmtBlock();
+    Stmt* declaration();
+    Stmt* assignment();
+    IdentifierExpr* identifierExpr();
+    Expr* boolExpr();
+    Expr* join();
+    Expr* eq();
+    Expr* rel();
+    Expr* expr();
+    Expr* term();
+    Expr* unary();
+    Expr* primary();
+    Expr* fnCall(Expr* id_expr);
+    Expr* listExpr(const Token& at);
 public:
-    Parser() { }
+    explicit Parser(Arena& arena) : arena(arena) { }
 
-    std::unique_ptr<Stmt> getAST(std::list<Token>& tokens);
+    Stmt* getAST(const TokenList& tokens);
+    // Number of nodes created by getAST()
+    size_t nodeCount() const { return nodes; }
 };
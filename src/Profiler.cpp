@@ -0,0 +1,143 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <filesystem>
+#include <iomanip>
+#include <map>
+
+namespace {
+    const char* expr_names[] = {
+            "Identifier", "BoolLiteral", "StringLiteral", "IntLiteral", "FloatLiteral",
+            "ToBool", "ToString", "ToInt", "ToFloat", "Mul", "Div", "IntDiv", "Add", "Sub",
+            "Eq", "NotEq", "Not", "Greater", "Less", "GreaterEq", "LessEq", "FnCall",
+            "Or", "And", "Mod", "Neg", "List", "IntBinaryOp", "FloatBinaryOp",
+    };
+    static_assert(std::size(expr_names) == (size_t)ExprType::Last);
+
+    const char* stmt_names[] = {
+            "Declaration", "Expression", "Assignment", "None", "If", "While", "DoWhile",
+            "For", "Block", "Function", "Return",
+    };
+    static_assert(std::size(stmt_names) == (size_t)StmtType::Last);
+
+    std::string nodeName(const Node* node) {
+        if (node->node_type == Node::NodeType::Stmt)
+            return stmt_names[(int)static_cast<const Stmt*>(node)->stmt_type];
+        auto expr = static_cast<const Expr*>(node);
+        if (auto e = dynamic_cast<const BinaryOpExpr*>(expr))
+            return expr_names[(int)e->op];
+        if (auto e = dynamic_cast<const FnCallExpr*>(expr))
+            if (auto id = dynamic_cast<const IdentifierExpr*>(e->id_expr))
+                return "FnCall " + std::string(id->id);
+        if (auto e = dynamic_cast<const IdentifierExpr*>(expr))
+            return "Identifier " + std::string(e->id);
+        return expr_names[(int)expr->expr_type];
+    }
+
+    double milliseconds(uint64_t ns) {
+        return ns / 1e6;
+    }
+}
+
+Profiler::Profiler(std::string file) : file(std::move(file)) {
+    paths.push_back({ 0, UINT32_MAX });
+}
+
+uint32_t Profiler::nodeId(const Node* node) {
+    auto [it, inserted] = node_ids.try_emplace(node, nodes.size());
+    if (inserted)
+    {
+        // A block shares its line with the statement that owns it or with its first statement, so only
+        // the statements themselves count as hits of a line
+        bool statement = node->node_type == Node::NodeType::Stmt
+                && static_cast<const Stmt*>(node)->stmt_type != StmtType::Block;
+        nodes.push_back({ nodeName(node), node->line, node->column, statement });
+    }
+    return it->second;
+}
+
+std::string Profiler::location(const NodeStats& stats) const {
+    return std::filesystem::path(file).filename().string() + ':' + std::to_string(stats.line) + ':' + std::to_string(stats.column);
+}
+
+void Profiler::enter(const Node* node) {
+    uint32_t id = nodeId(node);
+    uint32_t parent = stack.empty() ? 0 : stack.back().path;
+    auto [it, inserted] = path_ids.try_emplace((uint64_t)parent << 32 | id, paths.size());
+    if (inserted)
+        paths.push_back({ parent, id });
+    stack.push_back({ id, it->second, Clock::now() });
+}
+
+void Profiler::leave() {
+    auto frame = stack.back();
+    stack.pop_back();
+    uint64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - frame.start).count();
+    uint64_t self = elapsed - std::min(elapsed, frame.children_ns);
+    auto& stats = nodes[frame.node];
+    stats.hits++;
+    stats.total_ns += elapsed;
+    stats.self_ns += self;
+    paths[frame.path].self_ns += self;
+    if (!stack.empty())
+        stack.back().children_ns += elapsed;
+}
+
+void Profiler::report(std::ostream& out) const {
+    struct LineStats {
+        uint64_t hits = 0;
+        uint64_t self_ns = 0;
+    };
+    std::map<uint32_t, LineStats> lines;
+    for (auto& stats : nodes)
+    {
+        auto& line = lines[stats.line];
+        line.self_ns += stats.self_ns;
+        if (stats.statement)
+            line.hits += stats.hits;
+    }
+    std::vector<std::pair<uint32_t, LineStats>> sorted_lines(lines.begin(), lines.end());
+    std::stable_sort(sorted_lines.begin(), sorted_lines.end(), [](auto& a, auto& b) {
+        return a.second.self_ns > b.second.self_ns;
+    });
+
+    out << "Profile of " << file << '\n';
+    out << std::fixed << std::setprecision(3);
+    out << std::setw(12) << "self ms" << std::setw(12) << "hits" << "  line\n";
+    for (auto& [line, stats] : sorted_lines)
+        out << std::setw(12) << milliseconds(stats.self_ns) << std::setw(12) << stats.hits << "  " << line << '\n';
+
+    std::vector<const NodeStats*> sorted_nodes;
+    for (auto& stats : nodes)
+        sorted_nodes.push_back(&stats);
+    std::stable_sort(sorted_nodes.begin(), sorted_nodes.end(), [](auto a, auto b) {
+        return a->self_ns > b->self_ns;
+    });
+    const size_t node_limit = 30;
+    out << std::setw(12) << "self ms" << std::setw(12) << "total ms" << std::setw(12) << "hits" << "  node\n";
+    for (size_t i = 0; i < sorted_nodes.size() && i < node_limit; i++)
+    {
+        auto& stats = *sorted_nodes[i];
+        out << std::setw(12) << milliseconds(stats.self_ns) << std::setw(12) << milliseconds(stats.total_ns)
+            << std::setw(12) << stats.hits << "  " << location(stats) << ' ' << stats.name << '\n';
+    }
+    out << std::defaultfloat;
+}
+
+void Profiler::writeStacks(std::ostream& out) const {
+    std::vector<std::string> frames;
+    for (size_t i = 1; i < paths.size(); i++)
+    {
+        if (paths[i].self_ns == 0)
+            continue;
+        frames.clear();
+        for (size_t path = i; path != 0; path = paths[path].parent)
+        {
+            auto& stats = nodes[paths[path].node];
+            frames.push_back(stats.name + ' ' + location(stats));
+        }
+        out << file;
+        for (auto frame = frames.rbegin(); frame != frames.rend(); frame++)
+            out << ';' << *frame;
+        out << ' ' << paths[i].self_ns << '\n';
+    }
+}
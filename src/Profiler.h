@@ -0,0 +1,70 @@
+#pragma once
+#include "AST.h"
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Hit counts and time per AST node of one script, collected by Interpreter::eval/exec under --profile.
+// Self time excludes child nodes, so per-line sums don't count nested expressions twice.
+class Profiler {
+    using Clock = std::chrono::steady_clock;
+
+    struct NodeStats {
+        std::string name;
+        uint32_t line;
+        uint32_t column;
+        bool statement; // counted in the hits of its line, blocks are not
+        uint64_t hits = 0;
+        uint64_t total_ns = 0;
+        uint64_t self_ns = 0;
+    };
+
+    // Node in the tree of call paths, paths[0] stands for the script itself
+    struct Path {
+        uint32_t parent;
+        uint32_t node;
+        uint64_t self_ns = 0;
+    };
+
+    struct Frame {
+        uint32_t node;
+        uint32_t path;
+        Clock::time_point start;
+        uint64_t children_ns = 0;
+    };
+
+    std::string file;
+    std::vector<NodeStats> nodes;
+    std::unordered_map<const Node*, uint32_t> node_ids;
+    std::vector<Path> paths;
+    std::unordered_map<uint64_t, uint32_t> path_ids; // parent path << 32 | node
+    std::vector<Frame> stack;
+
+    uint32_t nodeId(const Node* node);
+    std::string location(const NodeStats& stats) const;
+public:
+    explicit Profiler(std::string file);
+
+    void enter(const Node* node);
+    void leave();
+
+    // Lines and nodes sorted by self time
+    void report(std::ostream& out) const;
+    // One "frame;frame;frame nanoseconds" line per call path, the input format of flame graph tools
+    void writeStacks(std::ostream& out) const;
+
+    // Profiles one eval/exec, leaves the node even if it throws
+    class Scope {
+        Profiler* profiler;
+    public:
+        Scope(Profiler* profiler, const Node* node) : profiler(profiler) {
+            profiler->enter(node);
+        }
+        ~Scope() {
+            profiler->leave();
+        }
+    };
+};
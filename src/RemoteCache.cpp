@@ -0,0 +1,318 @@
+#include "RemoteCache.h"
+#include <boost/asio/connect.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace http = boost::beast::http;
+using boost::asio::ip::tcp;
+
+namespace {
+    // Leads every packed body, bodies in another format are treated as misses
+    const char pack_magic[4] = { 'B', 'M', 'R', 'C' };
+    const uint32_t pack_version = 2;
+    // A server that makes no progress for this long is treated as gone and everything queued as a miss
+    const auto request_timeout = std::chrono::seconds(10);
+}
+
+// Requests are written back to back and the responses read in the same order. Everything runs on the I/O thread.
+struct RemoteCache::Connection {
+    using Done = std::function<void(unsigned status, std::string body)>;
+
+    struct Request {
+        http::request<http::string_body> message;
+        Done done;
+    };
+
+    RemoteCache& cache;
+    tcp::resolver resolver;
+    tcp::socket socket;
+    boost::asio::steady_timer deadline;
+    boost::beast::flat_buffer buffer;
+    std::optional<http::response_parser<http::string_body>> parser;
+    std::deque<Request> unsent;
+    std::deque<Request> unanswered;
+    bool connecting = false;
+    bool connected = false;
+    bool writing = false;
+    bool reading = false;
+    unsigned generation = 0; // handlers of a connection that already failed are ignored
+
+    explicit Connection(RemoteCache& cache)
+        : cache(cache), resolver(cache.context), socket(cache.context), deadline(cache.context) { }
+
+    void send(Request request) {
+        unsent.push_back(std::move(request));
+        if (connected)
+            write();
+        else
+            connect();
+        arm();
+    }
+
+    // Restarts the deadline whenever a step completes, so the oldest outstanding request bounds the wait
+    void arm() {
+        if (unsent.empty() && unanswered.empty())
+        {
+            deadline.cancel();
+            return;
+        }
+        deadline.expires_after(request_timeout);
+        deadline.async_wait([this, current = generation](boost::system::error_code error) {
+            if (!error && current == generation)
+                fail();
+        });
+    }
+
+    void connect() {
+        if (connecting)
+            return;
+        connecting = true;
+        resolver.async_resolve(cache.host, cache.port, [this, current = generation](boost::system::error_code error, tcp::resolver::results_type results) {
+            if (current != generation)
+                return;
+            if (error)
+                return fail();
+            boost::asio::async_connect(socket, results, [this, current](boost::system::error_code error, const tcp::endpoint&) {
+                if (current != generation)
+                    return;
+                connecting = false;
+                if (error)
+                    return fail();
+                connected = true;
+                write();
+                arm();
+            });
+        });
+    }
+
+    void write() {
+        if (writing || unsent.empty())
+            return;
+        writing = true;
+        http::async_write(socket, unsent.front().message, [this, current = generation](boost::system::error_code error, size_t) {
+            if (current != generation)
+                return;
+            writing = false;
+            if (error)
+                return fail();
+            unanswered.push_back(std::move(unsent.front()));
+            unsent.pop_front();
+            read();
+            write();
+            arm();
+        });
+    }
+
+    void read() {
+        if (reading || unanswered.empty())
+            return;
+        reading = true;
+        parser.emplace();
+        parser->body_limit(max_body);
+        http::async_read(socket, buffer, *parser, [this, current = generation](boost::system::error_code error, size_t) {
+            if (current != generation)
+                return;
+            reading = false;
+            if (error)
+                return fail();
+            auto response = parser->release();
+            auto request = std::move(unanswered.front());
+            unanswered.pop_front();
+            request.done(response.result_int(), std::move(response.body()));
+            if (!response.keep_alive())
+                return fail();
+            read();
+            arm();
+        });
+    }
+
+    // Closes the connection and answers everything still queued as failed, the next request reconnects
+    void fail() {
+        generation++;
+        connecting = connected = writing = reading = false;
+        deadline.cancel();
+        boost::system::error_code ignored;
+        resolver.cancel();
+        socket.close(ignored);
+        buffer.clear();
+        auto failed = std::move(unanswered);
+        for (auto& request : unsent)
+            failed.push_back(std::move(request));
+        unanswered.clear();
+        unsent.clear();
+        for (auto& request : failed)
+            request.done(0, { });
+    }
+};
+
+namespace {
+    const char url_scheme[] = "http://";
+}
+
+RemoteCache::RemoteCache(const std::string& url) : work(context.get_executor()) {
+    if (url.rfind(url_scheme, 0) != 0)
+        throw std::exception("Remote cache URL must look like http://host:port/path");
+    auto rest = url.substr(std::strlen(url_scheme));
+    auto slash = rest.find('/');
+    auto authority = rest.substr(0, slash);
+    prefix = slash == std::string::npos ? "" : rest.substr(slash);
+    while (!prefix.empty() && prefix.back() == '/')
+        prefix.pop_back();
+    auto colon = authority.rfind(':');
+    host = authority.substr(0, colon);
+    port = colon == std::string::npos ? "80" : authority.substr(colon + 1);
+    if (host.empty() || port.empty())
+        throw std::exception("Remote cache URL must look like http://host:port/path");
+
+    lookups = std::make_unique<Connection>(*this);
+    uploads = std::make_unique<Connection>(*this);
+    thread = std::thread([this]() { context.run(); });
+}
+
+RemoteCache::~RemoteCache() {
+    flush();
+    work.reset();
+    context.stop();
+    thread.join();
+}
+
+std::string RemoteCache::target(uint64_t key) {
+    std::ostringstream out;
+    out << prefix << "/cas/" << std::hex << std::setw(16) << std::setfill('0') << key;
+    return out.str();
+}
+
+void RemoteCache::lookup(uint64_t key, Callback done) {
+    Connection::Request request;
+    request.message = { http::verb::get, target(key), 11 };
+    request.message.set(http::field::host, host);
+    request.message.keep_alive(true);
+    request.done = [done = std::move(done)](unsigned status, std::string body) {
+        if (status == 200)
+            done(std::move(body));
+        else
+            done(std::nullopt);
+    };
+    boost::asio::post(context, [this, request = std::move(request)]() mutable { lookups->send(std::move(request)); });
+}
+
+void RemoteCache::store(uint64_t key, std::string body) {
+    {
+        std::lock_guard lock(storing_mutex);
+        storing++;
+    }
+    Connection::Request request;
+    request.message = { http::verb::put, target(key), 11 };
+    request.message.set(http::field::host, host);
+    request.message.set(http::field::content_type, "application/octet-stream");
+    request.message.keep_alive(true);
+    request.message.body() = std::move(body);
+    request.message.prepare_payload();
+    request.done = [this](unsigned, std::string) {
+        std::lock_guard lock(storing_mutex);
+        if (--storing == 0)
+            stored.notify_all();
+    };
+    boost::asio::post(context, [this, request = std::move(request)]() mutable { uploads->send(std::move(request)); });
+}
+
+void RemoteCache::flush() {
+    // Uploads are best effort, a server that stopped answering doesn't keep the build from exiting
+    std::unique_lock lock(storing_mutex);
+    stored.wait_for(lock, std::chrono::seconds(30), [this]() { return storing == 0; });
+}
+
+std::optional<std::string> RemoteCache::pack(const Rule& rule) {
+    std::string body(pack_magic, 4);
+    body.append(reinterpret_cast<const char*>(&pack_version), sizeof(pack_version));
+    auto append = [&body](uint64_t value) { body.append(reinterpret_cast<const char*>(&value), sizeof(value)); };
+    append(rule.outputs.size());
+    for (auto& output : rule.outputs)
+    {
+        std::error_code error;
+        auto status = std::filesystem::status(rule.directory / output, error);
+        std::ifstream in(rule.directory / output, std::ios::binary);
+        if (error || !in)
+            return std::nullopt;
+        std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        append((uint64_t)status.permissions());
+        append(data.size());
+        body += data;
+        if (body.size() > max_body)
+            return std::nullopt;
+    }
+    return body;
+}
+
+bool RemoteCache::unpack(std::string_view body, const Rule& rule) {
+    uint32_t version;
+    if (body.size() < 4 + sizeof(version) || !std::equal(pack_magic, pack_magic + 4, body.data()))
+        return false;
+    std::memcpy(&version, body.data() + 4, sizeof(version));
+    body.remove_prefix(4 + sizeof(version));
+    auto take = [&body](uint64_t& value) {
+        if (body.size() < sizeof(value))
+            return false;
+        std::memcpy(&value, body.data(), sizeof(value));
+        body.remove_prefix(sizeof(value));
+        return true;
+    };
+    uint64_t count;
+    if (version != pack_version || !take(count) || count != rule.outputs.size())
+        return false;
+
+    // The whole body is checked before anything is written
+    struct Output {
+        std::filesystem::perms mode;
+        std::string_view data;
+    };
+    std::vector<Output> outputs;
+    for (uint64_t i = 0; i < count; i++)
+    {
+        uint64_t mode, size;
+        if (!take(mode) || !take(size) || body.size() < size)
+            return false;
+        outputs.push_back({ (std::filesystem::perms)mode & std::filesystem::perms::all, body.substr(0, size) });
+        body.remove_prefix(size);
+    }
+    if (!body.empty())
+        return false;
+
+    for (size_t i = 0; i < outputs.size(); i++)
+    {
+        // Written under a private name and renamed, so a failed unpack never leaves half an output behind
+        auto target = rule.directory / rule.outputs[i];
+        std::ostringstream name;
+        name << target.filename().string() << '.' << std::this_thread::get_id() << ".tmp";
+        auto temp = target.parent_path() / name.str();
+        std::error_code error;
+        std::filesystem::create_directories(target.parent_path(), error);
+        bool written;
+        {
+            std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+            written = out && out.write(outputs[i].data.data(), outputs[i].data.size()) && out.flush();
+        }
+        if (written)
+            std::filesystem::permissions(temp, outputs[i].mode, error);
+        if (written && !error)
+            std::filesystem::rename(temp, target, error);
+        if (!written || error)
+        {
+            std::filesystem::remove(temp, error);
+            return false;
+        }
+    }
+    return true;
+}
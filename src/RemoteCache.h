@@ -0,0 +1,58 @@
+#pragma once
+#include "BuildGraph.h"
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+
+// Client for a remote output cache speaking plain HTTP/1.1: GET and PUT of <prefix>/cas/<key>, where the body
+// packs all outputs of a rule. Requests are pipelined on persistent connections driven by one I/O thread,
+// so lookups for many ready rules are in flight at once while the executor's workers keep running rules.
+// Any error, or a server that stops answering, is treated as a miss.
+class RemoteCache {
+public:
+    using Callback = std::function<void(std::optional<std::string> body)>;
+    // Largest body sent or accepted, rules with bigger outputs aren't shared
+    static constexpr uint64_t max_body = 1ull << 30;
+private:
+    struct Connection;
+
+    boost::asio::io_context context;
+    boost::asio::executor_work_guard<boost::asio::io_context::executor_type> work;
+    std::string host;
+    std::string port;
+    std::string prefix;
+    // Uploads get their own connection, so a large body doesn't hold up lookups behind it
+    std::unique_ptr<Connection> lookups;
+    std::unique_ptr<Connection> uploads;
+    std::thread thread;
+    size_t storing = 0;
+    std::mutex storing_mutex;
+    std::condition_variable stored;
+
+    std::string target(uint64_t key);
+public:
+    // url is http://host[:port][/prefix]
+    explicit RemoteCache(const std::string& url);
+    ~RemoteCache();
+    RemoteCache(const RemoteCache&) = delete;
+    RemoteCache& operator=(const RemoteCache&) = delete;
+
+    // done runs on the I/O thread and must not block
+    void lookup(uint64_t key, Callback done);
+    void store(uint64_t key, std::string body);
+    // Waits until every upload has been answered
+    void flush();
+
+    // Output files of a rule as one body: magic and version, count, then permissions, size and bytes of each output
+    static std::optional<std::string> pack(const Rule& rule);
+    static bool unpack(std::string_view body, const Rule& rule);
+};
@@ -0,0 +1,137 @@
+#include "Resolver.h"
+
+void Resolver::resolve(Stmt* ast) {
+    scope = nullptr;
+    blocks.clear();
+    function_base = 0;
+    stmt(ast);
+}
+
+void Resolver::block(BlockStmt* ast, const std::pmr::vector<std::string_view>* params) {
+    scope = std::make_shared<SymbolTable>(scope);
+    blocks.push_back(ast);
+    ast->names.clear();
+    if (params != nullptr)
+        for (auto param : *params)
+        {
+            scope->addVariable(param, ast->names.size());
+            ast->names.push_back(param);
+        }
+    for (auto s : ast->stmts)
+        stmt(s);
+    blocks.pop_back();
+    scope = scope->up;
+}
+
+void Resolver::identifier(IdentifierExpr* ast) {
+    ValueID slot;
+    if (scope == nullptr || !scope->findVariable(ast->id, ast->depth, slot))
+        throw std::exception("Unknown variable");
+    ast->slot = slot;
+    if (function_base != 0 && ast->depth >= blocks.size() - function_base)
+    {
+        if (ast->depth != blocks.size() - 1)
+            throw std::exception("Functions can only use their own and global variables");
+        ast->depth = Memory::global_depth;
+    }
+}
+
+void Resolver::stmt(Stmt* ast) {
+    switch (ast->stmt_type) {
+        case StmtType::Declaration: {
+            auto s = dynamic_cast<DeclarationStmt*>(ast);
+            expr(s->right);
+            auto current = blocks.back();
+            s->id->depth = 0;
+            s->id->slot = current->names.size();
+            current->names.push_back(s->id->id);
+            scope->addVariable(s->id->id, s->id->slot);
+            break;
+        }
+        case StmtType::Assignment: {
+            auto s = dynamic_cast<AssignmentStmt*>(ast);
+            expr(s->right);
+            expr(s->left);
+            break;
+        }
+        case StmtType::Expression:
+            expr(dynamic_cast<ExpressionStmt*>(ast)->expr);
+            break;
+        case StmtType::If: {
+            auto s = dynamic_cast<IfStmt*>(ast);
+            expr(s->cond);
+            block(s->action);
+            block(s->else_action);
+            break;
+        }
+        case StmtType::While: {
+            auto s = dynamic_cast<WhileStmt*>(ast);
+            expr(s->cond);
+            block(s->action);
+            break;
+        }
+        case StmtType::DoWhile: {
+            auto s = dynamic_cast<DoWhileStmt*>(ast);
+            block(s->action);
+            expr(s->cond);
+            break;
+        }
+        case StmtType::Block:
+            block(dynamic_cast<BlockStmt*>(ast));
+            break;
+        case StmtType::Function: {
+            auto s = dynamic_cast<FunctionStmt*>(ast);
+            size_t outer = function_base;
+            function_base = blocks.size();
+            block(s->body, &s->params);
+            function_base = outer;
+            break;
+        }
+        case StmtType::Return: {
+            auto s = dynamic_cast<ReturnStmt*>(ast);
+            if (function_base == 0)
+                throw std::exception("return outside of a function");
+            if (s->value != nullptr)
+                expr(s->value);
+            break;
+        }
+        case StmtType::None:
+            break;
+        default:
+            throw std::exception("Unsupported statement");
+    }
+}
+
+void Resolver::expr(Expr* ast) {
+    switch (ast->expr_type) {
+        case ExprType::Identifier:
+            identifier(dynamic_cast<IdentifierExpr*>(ast));
+            return;
+        case ExprType::BoolLiteral:
+        case ExprType::StringLiteral:
+        case ExprType::IntLiteral:
+        case ExprType::FloatLiteral:
+            return;
+        case ExprType::List:
+            for (auto item : dynamic_cast<ListExpr*>(ast)->items)
+                expr(item);
+            return;
+        case ExprType::FnCall: {
+            auto e = dynamic_cast<FnCallExpr*>(ast);
+            for (auto arg : e->args)
+                expr(arg);
+            for (auto& keyword : e->keywords)
+                expr(keyword.value);
+            return;
+        }
+        default:
+            break;
+    }
+    if (auto e = dynamic_cast<BinaryOpExpr*>(ast))
+    {
+        expr(e->left_expr);
+        expr(e->right_expr);
+    }
+    else if (auto e = dynamic_cast<UnaryOpExpr*>(ast))
+        expr(e->expr);
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include "AST.h"
+#include "SymbolTable.h"
+#include "Memory.h"
+
+// Binds every identifier to a (depth, slot) pair so the interpreter can
+// address variables in its frames without looking names up at runtime
+class Resolver {
+    std::shared_ptr<SymbolTable> scope;
+    std::vector<BlockStmt*> blocks;
+    size_t function_base = 0; // index in blocks of the innermost function body, 0 outside of functions
+
+    void stmt(Stmt* ast);
+    void block(BlockStmt* ast, const std::pmr::vector<std::string_view>* params = nullptr);
+    void expr(Expr* ast);
+    void identifier(IdentifierExpr* ast);
+public:
+    void resolve(Stmt* ast);
+};
@@ -0,0 +1,133 @@
+#pragma once
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define BMAKE_SCAN_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BMAKE_SCAN_SSE2
+#endif
+
+// Vectorized helpers for the lexer. Each one scans 32 (AVX2) or 16 (SSE2)
+// bytes per step and finishes the tail with the scalar loop.
+namespace scan {
+    inline bool isBlank(char ch) {
+        return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n';
+    }
+
+    inline bool isStringSpecial(char ch) {
+        return ch == '"' || ch == '\\' || ch == '\n' || ch == '\0';
+    }
+
+#ifdef BMAKE_SCAN_SSE2
+    inline __m128i eq16(__m128i block, char ch) {
+        return _mm_cmpeq_epi8(block, _mm_set1_epi8(ch));
+    }
+#endif
+#ifdef BMAKE_SCAN_AVX2
+    inline __m256i eq32(__m256i block, char ch) {
+        return _mm256_cmpeq_epi8(block, _mm256_set1_epi8(ch));
+    }
+#endif
+
+    // Index of the first byte that is not a space, tab or line break,
+    // newline is set when a '\n' is skipped on the way
+    inline size_t skipBlank(const char* data, size_t i, size_t size, bool& newline) {
+#ifdef BMAKE_SCAN_AVX2
+        for (; i + 32 <= size; i += 32)
+        {
+            __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            __m256i nl = eq32(block, '\n');
+            __m256i blank = _mm256_or_si256(_mm256_or_si256(eq32(block, ' '), eq32(block, '\t')),
+                                            _mm256_or_si256(eq32(block, '\r'), nl));
+            uint32_t stop = ~(uint32_t)_mm256_movemask_epi8(blank);
+            uint32_t lines = (uint32_t)_mm256_movemask_epi8(nl);
+            if (stop != 0)
+            {
+                int k = std::countr_zero(stop);
+                if (lines & ((1u << k) - 1))
+                    newline = true;
+                return i + k;
+            }
+            if (lines != 0)
+                newline = true;
+        }
+#endif
+#ifdef BMAKE_SCAN_SSE2
+        for (; i + 16 <= size; i += 16)
+        {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            __m128i nl = eq16(block, '\n');
+            __m128i blank = _mm_or_si128(_mm_or_si128(eq16(block, ' '), eq16(block, '\t')),
+                                         _mm_or_si128(eq16(block, '\r'), nl));
+            uint32_t stop = ~(uint32_t)_mm_movemask_epi8(blank) & 0xFFFF;
+            uint32_t lines = (uint32_t)_mm_movemask_epi8(nl);
+            if (stop != 0)
+            {
+                int k = std::countr_zero(stop);
+                if (lines & ((1u << k) - 1))
+                    newline = true;
+                return i + k;
+            }
+            if (lines != 0)
+                newline = true;
+        }
+#endif
+        for (; i < size && isBlank(data[i]); i++)
+            if (data[i] == '\n')
+                newline = true;
+        return i;
+    }
+
+    // Index of the first occurrence of ch, or size
+    inline size_t findByte(const char* data, size_t i, size_t size, char ch) {
+#ifdef BMAKE_SCAN_AVX2
+        for (; i + 32 <= size; i += 32)
+        {
+            __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            if (uint32_t mask = (uint32_t)_mm256_movemask_epi8(eq32(block, ch)))
+                return i + std::countr_zero(mask);
+        }
+#endif
+#ifdef BMAKE_SCAN_SSE2
+        for (; i + 16 <= size; i += 16)
+        {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            if (uint32_t mask = (uint32_t)_mm_movemask_epi8(eq16(block, ch)))
+                return i + std::countr_zero(mask);
+        }
+#endif
+        for (; i < size && data[i] != ch; i++) { }
+        return i;
+    }
+
+    // Index of the next quote, backslash, line break or NUL inside a string literal, or size
+    inline size_t findStringSpecial(const char* data, size_t i, size_t size) {
+#ifdef BMAKE_SCAN_AVX2
+        for (; i + 32 <= size; i += 32)
+        {
+            __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            __m256i special = _mm256_or_si256(_mm256_or_si256(eq32(block, '"'), eq32(block, '\\')),
+                                              _mm256_or_si256(eq32(block, '\n'), eq32(block, '\0')));
+            if (uint32_t mask = (uint32_t)_mm256_movemask_epi8(special))
+                return i + std::countr_zero(mask);
+        }
+#endif
+#ifdef BMAKE_SCAN_SSE2
+        for (; i + 16 <= size; i += 16)
+        {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            __m128i special = _mm_or_si128(_mm_or_si128(eq16(block, '"'), eq16(block, '\\')),
+                                           _mm_or_si128(eq16(block, '\n'), eq16(block, '\0')));
+            if (uint32_t mask = (uint32_t)_mm_movemask_epi8(special))
+                return i + std::countr_zero(mask);
+        }
+#endif
+        for (; i < size && !isStringSpecial(data[i]); i++) { }
+        return i;
+    }
+}
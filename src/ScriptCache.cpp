@@ -0,0 +1,216 @@
+#include "ScriptCache.h"
+#include <boost/filesystem/fstream.hpp>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+namespace {
+    const char cache_magic[4] = { 'B', 'M', 'B', 'C' };
+    const size_t cache_alignment = 8;
+
+    struct CacheHeader {
+        char magic[4];
+        uint32_t version;
+        uint64_t script_hash;
+        uint32_t code_size;
+        uint32_t constants_size;
+        uint32_t functions_size;
+        uint32_t globals_size;
+        uint32_t procedures_size;
+        uint32_t strings_size;
+        uint16_t registers;
+    };
+
+    size_t aligned(size_t size) {
+        return (size + cache_alignment - 1) / cache_alignment * cache_alignment;
+    }
+
+    template<class T>
+    void writeSection(std::ostream& out, const T* data, size_t count) {
+        static const char padding[cache_alignment] = { };
+        size_t size = count * sizeof(T);
+        out.write(reinterpret_cast<const char*>(data), size);
+        out.write(padding, aligned(size) - size);
+    }
+
+    template<class T>
+    bool readSection(const char* data, size_t size, size_t& offset, size_t count, std::span<const T>& section) {
+        size_t bytes = count * sizeof(T);
+        if (offset + bytes > size)
+            return false;
+        section = { reinterpret_cast<const T*>(data + offset), count };
+        offset += aligned(bytes);
+        return true;
+    }
+
+    bool validString(const ProgramView& program, StringRef ref) {
+        return ref.offset <= program.strings.size() && ref.length <= program.strings.size() - ref.offset;
+    }
+
+    bool terminates(OpCode op) {
+        return op == OpCode::Jump || op == OpCode::Return || op == OpCode::Halt;
+    }
+
+    // The VM indexes registers, constants and tables without checks, so a cached program is only run
+    // if every operand stays inside its frame and pools and control never leaves the function it is in
+    bool validate(const ProgramView& program) {
+        for (auto& c : program.constants)
+            if (c.type > ConstantType::String || (c.type == ConstantType::String && !validString(program, c.str)))
+                return false;
+        for (auto& name : program.functions)
+            if (!validString(program, name))
+                return false;
+        for (auto& symbol : program.globals)
+            if (!validString(program, symbol.name) || symbol.reg >= program.registers)
+                return false;
+
+        // Every function body is preceded by a jump over it and may contain nested bodies,
+        // owner[i] is 0 for top level code and procedure index + 1 otherwise
+        const auto& code = program.code;
+        std::vector<uint32_t> owner(code.size(), 0);
+        for (size_t p = 0; p < program.procedures.size(); p++)
+        {
+            auto& procedure = program.procedures[p];
+            if (!validString(program, procedure.name) || procedure.params > procedure.registers
+                || procedure.entry == 0 || procedure.entry >= code.size() || code[procedure.entry - 1].op != OpCode::Jump)
+                return false;
+            uint32_t end = code[procedure.entry - 1].bx();
+            if (end <= procedure.entry || end > code.size())
+                return false;
+            uint32_t parent = owner[procedure.entry - 1];
+            for (uint32_t i = procedure.entry; i < end; i++)
+            {
+                if (owner[i] != parent)
+                    return false;
+                owner[i] = p + 1;
+            }
+        }
+
+        for (size_t i = 0; i < code.size(); i++)
+        {
+            const Instr& in = code[i];
+            if (in.op >= OpCode::Last)
+                return false;
+            size_t frame = owner[i] == 0 ? program.registers : program.procedures[owner[i] - 1].registers;
+            bool valid = in.a < frame;
+            switch (in.op) {
+                case OpCode::LoadConst:
+                    valid = valid && in.bx() < program.constants.size();
+                    break;
+                case OpCode::LoadGlobal:
+                case OpCode::StoreGlobal:
+                    valid = valid && in.bx() < program.registers;
+                    break;
+                case OpCode::MakeList:
+                    valid = valid && (size_t)in.b + in.c <= frame;
+                    break;
+                case OpCode::Call:
+                    valid = valid && in.b < program.functions.size() && (size_t)in.a + in.c + 2 * in.d < frame;
+                    break;
+                case OpCode::CallProc:
+                    valid = valid && in.b < program.procedures.size();
+                    break;
+                case OpCode::Return:
+                    valid = valid && owner[i] != 0;
+                    break;
+                case OpCode::Jump:
+                case OpCode::JumpIfFalse:
+                case OpCode::JumpIfTrue:
+                    valid = (in.op == OpCode::Jump || valid) && in.bx() < code.size() && owner[in.bx()] == owner[i];
+                    break;
+                case OpCode::Halt:
+                    valid = true;
+                    break;
+                default:
+                    valid = valid && in.b < frame && (in.op < OpCode::Add || in.op > OpCode::Or || in.c < frame);
+                    break;
+            }
+            if (!valid)
+                return false;
+            if (!terminates(in.op) && (i + 1 == code.size() || owner[i + 1] != owner[i]))
+                return false;
+        }
+        return !code.empty();
+    }
+}
+
+bool ScriptCache::load(uint64_t script_hash, ProgramView& program) {
+    boost::system::error_code error;
+    auto size = boost::filesystem::file_size(path, error);
+    if (error || size < sizeof(CacheHeader))
+        return false;
+    try {
+        file.open(path);
+    }
+    catch (std::exception&) {
+        return false;
+    }
+    CacheHeader header;
+    std::memcpy(&header, file.data(), sizeof(CacheHeader));
+    if (!std::equal(header.magic, header.magic + 4, cache_magic) || header.version != bytecode_version
+        || header.script_hash != script_hash)
+    {
+        file.close();
+        return false;
+    }
+
+    ProgramView view;
+    size_t offset = aligned(sizeof(CacheHeader));
+    std::span<const char> strings;
+    if (!readSection(file.data(), file.size(), offset, header.code_size, view.code)
+        || !readSection(file.data(), file.size(), offset, header.constants_size, view.constants)
+        || !readSection(file.data(), file.size(), offset, header.functions_size, view.functions)
+        || !readSection(file.data(), file.size(), offset, header.globals_size, view.globals)
+        || !readSection(file.data(), file.size(), offset, header.procedures_size, view.procedures)
+        || !readSection(file.data(), file.size(), offset, header.strings_size, strings))
+    {
+        file.close();
+        return false;
+    }
+    view.strings = { strings.data(), strings.size() };
+    view.registers = header.registers;
+    if (!validate(view))
+    {
+        file.close();
+        return false;
+    }
+    program = view;
+    return true;
+}
+
+void ScriptCache::store(uint64_t script_hash, const Program& program) {
+    CacheHeader header{};
+    std::copy(cache_magic, cache_magic + 4, header.magic);
+    header.version = bytecode_version;
+    header.script_hash = script_hash;
+    header.code_size = program.code.size();
+    header.constants_size = program.constants.size();
+    header.functions_size = program.functions.size();
+    header.globals_size = program.globals.size();
+    header.procedures_size = program.procedures.size();
+    header.strings_size = program.strings.size();
+    header.registers = program.registers;
+
+    // Concurrent evaluations of the same script may store at once, each writes under its own name
+    auto temp = path.parent_path() / boost::filesystem::unique_path(path.filename().string() + ".%%%%%%%%.tmp");
+    {
+        boost::filesystem::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        if (!out)
+        {
+            std::cout << "Can't write script cache " << path.string() << '\n';
+            return;
+        }
+        writeSection(out, &header, 1);
+        writeSection(out, program.code.data(), program.code.size());
+        writeSection(out, program.constants.data(), program.constants.size());
+        writeSection(out, program.functions.data(), program.functions.size());
+        writeSection(out, program.globals.data(), program.globals.size());
+        writeSection(out, program.procedures.data(), program.procedures.size());
+        writeSection(out, program.strings.data(), program.strings.size());
+    }
+    boost::system::error_code error;
+    boost::filesystem::rename(temp, path, error);
+    if (error)
+        boost::filesystem::remove(temp, error);
+}
@@ -0,0 +1,17 @@
+#pragma once
+#include "Bytecode.h"
+#include <boost/filesystem.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <cstdint>
+
+// Compiled bytecode of a script, stored beside the script and keyed by its content hash.
+// A valid cache file is memory-mapped and executed in place, skipping lexing, parsing and compilation.
+class ScriptCache {
+    boost::filesystem::path path;
+    boost::iostreams::mapped_file_source file;
+public:
+    explicit ScriptCache(boost::filesystem::path path) : path(std::move(path)) { }
+
+    bool load(uint64_t script_hash, ProgramView& program);
+    void store(uint64_t script_hash, const Program& program);
+};
@@ -0,0 +1,31 @@
+#pragma once
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <filesystem>
+#include <string_view>
+
+// Read-only memory mapping of a script, lexed in place without copying
+class ScriptFile {
+    boost::iostreams::mapped_file_source file;
+public:
+    bool open(const std::filesystem::path& path) {
+        std::error_code error;
+        auto size = std::filesystem::file_size(path, error);
+        if (error)
+            return false;
+        if (size == 0)
+            return true;
+        try {
+            file.open(path.string());
+        }
+        catch (std::exception&) {
+            return false;
+        }
+        return file.is_open();
+    }
+
+    std::string_view code() const {
+        if (!file.is_open())
+            return { };
+        return { file.data(), file.size() };
+    }
+};
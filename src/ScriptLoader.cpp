@@ -0,0 +1,405 @@
+#include "ScriptLoader.h"
+#include "constants.h"
+#include "Lexer.h"
+#include "Parser.h"
+#include "Resolver.h"
+#include "Optimizer.h"
+#include "Compiler.h"
+#include "VM.h"
+#include "ScriptFile.h"
+#include "ScriptCache.h"
+#include "BuildDatabase.h"
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <optional>
+#include <utility>
+
+namespace {
+    // "dir" means dir/script.bm, "dir/name" means dir/name.bm unless a file with that exact name exists
+    std::filesystem::path scriptPath(const std::filesystem::path& path) {
+        if (std::filesystem::is_directory(path))
+            return path / script_default_name;
+        if (!path.has_extension() && !std::filesystem::exists(path))
+            return std::filesystem::path(path) += std::filesystem::path(script_default_name).extension();
+        return path;
+    }
+
+    Stmt* parseScript(std::string_view code, std::unique_ptr<Arena>& arena, Interpreter& interpreter, bool root,
+                      Tracer* tracer, const std::string& name) {
+        TokenList token_list;
+        {
+            Tracer::Span span(tracer, "lex " + name, "configure");
+            auto lexer = Lexer();
+            token_list = lexer.tokenize(code);
+        }
+        arena = std::make_unique<Arena>(token_list.size() * 32);
+        Stmt* ast;
+        {
+            Tracer::Span span(tracer, "parse " + name, "configure");
+            auto parser = Parser(*arena);
+            ast = parser.getAST(token_list);
+            auto optimizer = Optimizer(*arena, interpreter);
+            ast = optimizer.optimize(ast);
+        }
+        if (root)
+            std::cout << "Parsed\n";
+        return ast;
+    }
+
+    const char memo_magic[4] = { 'B', 'M', 'M', 'O' };
+    const uint32_t memo_version = 2;
+
+    template<class T>
+    void append(std::string& out, T value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void serialize(const Value& value, std::string& out) {
+        append<uint8_t>(out, (uint8_t)value.type);
+        if (value.type == ValueType::String)
+        {
+            append<uint32_t>(out, value.str_val->size());
+            out += *value.str_val;
+        }
+        else if (value.type == ValueType::List)
+        {
+            append<uint32_t>(out, value.list_val->size());
+            for (auto& item : *value.list_val)
+                serialize(item, out);
+        }
+        else
+            append<uint64_t>(out, value.copy);
+    }
+
+    template<class T>
+    bool take(std::string_view& data, T& value) {
+        if (data.size() < sizeof(T))
+            return false;
+        std::memcpy(&value, data.data(), sizeof(T));
+        data.remove_prefix(sizeof(T));
+        return true;
+    }
+
+    bool deserialize(std::string_view& data, Value& value) {
+        uint8_t type;
+        if (!take(data, type) || type > (uint8_t)ValueType::List)
+            return false;
+        if (type == (uint8_t)ValueType::String)
+        {
+            uint32_t size;
+            if (!take(data, size) || data.size() < size)
+                return false;
+            value = Value::String(data.substr(0, size));
+            data.remove_prefix(size);
+            return true;
+        }
+        if (type == (uint8_t)ValueType::List)
+        {
+            uint32_t size;
+            if (!take(data, size))
+                return false;
+            std::vector<Value> items;
+            items.reserve(std::min<size_t>(size, data.size()));
+            for (uint32_t i = 0; i < size; i++)
+                if (!deserialize(data, items.emplace_back()))
+                    return false;
+            value = Value::List(std::move(items));
+            return true;
+        }
+        uint64_t bits;
+        if (!take(data, bits))
+            return false;
+        value = Value();
+        value.type = (ValueType)type;
+        value.copy = bits;
+        return true;
+    }
+
+    bool helpersChanged(const std::vector<std::pair<std::string, uint64_t>>& helpers) {
+        for (auto& [path, hash] : helpers)
+            if (BuildDatabase::hashFile(path) != hash)
+                return true;
+        return false;
+    }
+
+    void writeString(std::ostream& out, std::string_view str) {
+        uint32_t size = str.size();
+        out.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        out.write(str.data(), str.size());
+    }
+
+    bool readString(std::istream& in, std::string& str) {
+        uint32_t size = 0;
+        in.read(reinterpret_cast<char*>(&size), sizeof(size));
+        str.resize(size);
+        return (bool)in.read(str.data(), size);
+    }
+}
+
+std::shared_ptr<Script> ScriptLoader::load(const std::filesystem::path& path) {
+    auto script = std::make_shared<Script>();
+    script->path = path.lexically_normal();
+    evaluate(*script, true);
+    return script;
+}
+
+void ScriptLoader::reload(Script& script, bool root) {
+    script.children.clear();
+    script.helpers.clear();
+    script.error = nullptr;
+    script.interpreter.reset();
+    script.profiler.reset();
+    script.result = Value();
+    try {
+        evaluate(script, root);
+    }
+    catch (...) {
+        script.error = std::current_exception();
+    }
+}
+
+void ScriptLoader::spawn(Script& parent, const std::filesystem::path& path, std::string entry, std::vector<Value> args) {
+    auto script = std::make_shared<Script>();
+    script->path = scriptPath(path.lexically_normal());
+    script->entry = std::move(entry);
+    script->args = std::move(args);
+    parent.children.push_back(script);
+    pool.submit([this, script]() {
+        try {
+            evaluate(*script, false);
+        }
+        catch (...) {
+            script->error = std::current_exception();
+        }
+    });
+}
+
+void ScriptLoader::wait() {
+    pool.wait();
+}
+
+void ScriptLoader::evaluate(Script& script, bool root) {
+    auto name = script.path.string();
+    Tracer::Span span(tracer, "script " + name, "configure");
+    {
+        std::lock_guard lock(sources_mutex);
+        sources.push_back(script.path);
+    }
+    ScriptFile file;
+    if (!file.open(script.path))
+        throw std::exception(("Can't open " + script.path.string()).c_str());
+
+    script.interpreter = std::make_unique<Interpreter>();
+    auto& interpreter = *script.interpreter;
+    interpreter.buildGraph.directory = script.path.parent_path();
+    interpreter.loader = this;
+    interpreter.script = &script;
+    interpreter.verbose = root;
+
+    if (tree_walk)
+    {
+        std::unique_ptr<Arena> arena;
+        auto ast = parseScript(file.code(), arena, interpreter, root, tracer, name);
+        {
+            Tracer::Span span(tracer, "resolve " + name, "configure");
+            auto resolver = Resolver();
+            resolver.resolve(ast);
+        }
+        if (profile)
+        {
+            script.profiler = std::make_unique<Profiler>(script.path.string());
+            interpreter.profiler = script.profiler.get();
+        }
+        Tracer::Span span(tracer, "interpret " + name, "configure");
+        script.result = interpreter.run(ast, script.entry, script.args);
+        return;
+    }
+
+    uint64_t script_hash = hashString(file.code());
+    // One cache file per script, helpers and subdirectory scripts sharing a directory would evict each other
+    ScriptCache cache(script.path.string() + script_cache_suffix);
+    Program compiled;
+    ProgramView program;
+    bool cached;
+    {
+        Tracer::Span span(tracer, "cache load " + name, "configure");
+        cached = cache.load(script_hash, program);
+    }
+    if (!cached)
+    {
+        std::unique_ptr<Arena> arena;
+        auto ast = parseScript(file.code(), arena, interpreter, root, tracer, name);
+        {
+            Tracer::Span span(tracer, "compile " + name, "configure");
+            auto compiler = Compiler();
+            compiled = compiler.compile(ast);
+            cache.store(script_hash, compiled);
+        }
+        program = compiled.view();
+    }
+    Tracer::Span interpret_span(tracer, "interpret " + name, "configure");
+    auto vm = VM(interpreter);
+    vm.run(program);
+    if (!script.entry.empty())
+        script.result = vm.invoke(program, script.entry, std::move(script.args));
+    if (root)
+        vm.print(program);
+}
+
+void ScriptLoader::writeProfile(Script& script, std::ostream& report, std::ostream& stacks) {
+    if (script.profiler != nullptr)
+    {
+        script.profiler->report(report);
+        script.profiler->writeStacks(stacks);
+    }
+    for (auto& child : script.children)
+        writeProfile(*child, report, stacks);
+}
+
+void ScriptLoader::merge(Script& script, BuildGraph& graph, bool keep) {
+    Tracer::Span span(tracer, "merge " + script.path.string(), "graph");
+    if (script.error)
+        std::rethrow_exception(script.error);
+    if (script.interpreter == nullptr)
+        return;
+    if (keep)
+        graph.append(std::as_const(script.interpreter->buildGraph));
+    else
+        graph.append(script.interpreter->buildGraph);
+    for (auto& child : script.children)
+        merge(*child, graph, keep);
+}
+
+Value ScriptLoader::runScript(Script* caller, const std::filesystem::path& path, const std::string& entry,
+                              std::vector<Value> args) {
+    Script script;
+    script.path = scriptPath(path.lexically_normal());
+    auto hash = BuildDatabase::hashFile(script.path.string());
+    if (!hash)
+        throw std::exception(("Can't open " + script.path.string()).c_str());
+
+    std::string key;
+    append<uint64_t>(key, *hash);
+    key += entry;
+    key += '\0';
+    for (auto& arg : args)
+        serialize(arg, key);
+    // The key only covers this script, results depending on nested run_script() calls are checked against their
+    // hashes too. The caller inherits every script involved, so its own memo entry is invalidated by them as well.
+    auto report = [&](const std::vector<std::pair<std::string, uint64_t>>& helpers) {
+        if (caller == nullptr)
+            return;
+        caller->helpers.emplace_back(script.path.string(), *hash);
+        caller->helpers.insert(caller->helpers.end(), helpers.begin(), helpers.end());
+    };
+    std::optional<MemoEntry> cached;
+    {
+        std::lock_guard lock(memo_mutex);
+        if (auto it = memo.find(key); it != memo.end())
+            cached = it->second;
+    }
+    if (cached && !helpersChanged(cached->helpers))
+    {
+        // Never evaluated in this run, but the daemon and --watch still have to notice when they change
+        {
+            std::lock_guard lock(sources_mutex);
+            sources.push_back(script.path);
+            for (auto& [helper, hash] : cached->helpers)
+                sources.push_back(helper);
+        }
+        report(cached->helpers);
+        return std::move(cached->value);
+    }
+
+    // Evaluated outside the lock, two threads asking for the same key at once both compute it
+    script.entry = entry;
+    script.args = std::move(args);
+    evaluate(script, false);
+    if (script.interpreter->buildGraph.size() != 0 || !script.children.empty())
+        throw std::exception("run_script() scripts can't add rules");
+    report(script.helpers);
+    std::lock_guard lock(memo_mutex);
+    memo[key] = { script.result, std::move(script.helpers) };
+    memo_changed = true;
+    return std::move(script.result);
+}
+
+void ScriptLoader::loadMemo(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        return;
+    char magic[4];
+    uint32_t version = 0, count = 0;
+    in.read(magic, 4);
+    in.read(reinterpret_cast<char*>(&version), sizeof(version));
+    in.read(reinterpret_cast<char*>(&count), sizeof(count));
+    if (!in || !std::equal(magic, magic + 4, memo_magic) || version != memo_version)
+        return;
+    std::lock_guard lock(memo_mutex);
+    std::string key, bytes;
+    for (uint32_t i = 0; i < count && readString(in, key) && readString(in, bytes); i++)
+    {
+        std::string_view data = bytes;
+        MemoEntry entry;
+        uint32_t helpers = 0;
+        if (!deserialize(data, entry.value) || !take(data, helpers))
+            continue;
+        for (uint32_t j = 0; j < helpers; j++)
+        {
+            uint32_t size;
+            uint64_t hash;
+            if (!take(data, size) || data.size() < size)
+                break;
+            std::string helper(data.substr(0, size));
+            data.remove_prefix(size);
+            if (!take(data, hash))
+                break;
+            entry.helpers.emplace_back(std::move(helper), hash);
+        }
+        if (entry.helpers.size() == helpers)
+            memo[key] = std::move(entry);
+    }
+}
+
+void ScriptLoader::saveMemo(const std::filesystem::path& path) {
+    std::lock_guard lock(memo_mutex);
+    if (!memo_changed)
+        return;
+    auto temp = path;
+    temp += ".tmp";
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        if (!out)
+        {
+            std::cout << "Can't write run_script memo " << path.string() << '\n';
+            return;
+        }
+        uint32_t version = memo_version, count = memo.size();
+        out.write(memo_magic, 4);
+        out.write(reinterpret_cast<const char*>(&version), sizeof(version));
+        out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        std::string bytes;
+        for (auto& [key, entry] : memo)
+        {
+            bytes.clear();
+            serialize(entry.value, bytes);
+            append<uint32_t>(bytes, entry.helpers.size());
+            for (auto& [helper, hash] : entry.helpers)
+            {
+                append<uint32_t>(bytes, helper.size());
+                bytes += helper;
+                append<uint64_t>(bytes, hash);
+            }
+            writeString(out, key);
+            writeString(out, bytes);
+        }
+    }
+    std::error_code error;
+    std::filesystem::rename(temp, path, error);
+}
+
+std::vector<std::filesystem::path> ScriptLoader::loadedScripts() {
+    std::lock_guard lock(sources_mutex);
+    return sources;
+}
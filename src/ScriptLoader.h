@@ -0,0 +1,68 @@
+#pragma once
+#include "Interpreter.h"
+#include "ThreadPool.h"
+#include "Tracer.h"
+#include <exception>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// A script evaluated by its own interpreter, its subdirectory() calls become children
+struct Script {
+    std::filesystem::path path;
+    std::string entry;
+    std::vector<Value> args;
+    std::unique_ptr<Interpreter> interpreter;
+    std::vector<std::shared_ptr<Script>> children; // in call order, only touched by the thread evaluating this script
+    std::exception_ptr error;
+    Value result; // value returned by the entry function
+    std::unique_ptr<Profiler> profiler;
+    // run_script() scripts evaluated on its behalf, nested ones included, with their content hashes
+    std::vector<std::pair<std::string, uint64_t>> helpers;
+};
+
+// Evaluates subdirectory scripts on a thread pool while their parents keep running.
+// Every script has its own Interpreter, Memory and BuildGraph, so nothing is shared between them
+// and the rules are merged afterwards in call order, independent of which script finished first.
+class ScriptLoader {
+    ThreadPool pool;
+    bool tree_walk;
+    bool profile;
+    Tracer* tracer;
+    struct MemoEntry {
+        Value value;
+        std::vector<std::pair<std::string, uint64_t>> helpers; // must still hash the same for the value to be reused
+    };
+
+    // run_script() results keyed by script content hash, entry point and arguments
+    std::unordered_map<std::string, MemoEntry> memo;
+    std::mutex memo_mutex;
+    bool memo_changed = false;
+    std::vector<std::filesystem::path> sources; // every script evaluated or answered from the memo, including missing ones
+    std::mutex sources_mutex;
+
+    void evaluate(Script& script, bool root);
+public:
+    // Profiling instruments the tree walker, so it implies tree_walk
+    ScriptLoader(size_t jobs, bool tree_walk, bool profile = false, Tracer* tracer = nullptr)
+        : pool(jobs), tree_walk(tree_walk || profile), profile(profile), tracer(tracer) { }
+
+    std::shared_ptr<Script> load(const std::filesystem::path& path);
+    // Evaluates a script again with its entry and arguments, its subdirectory() calls are spawned anew
+    void reload(Script& script, bool root);
+    void spawn(Script& parent, const std::filesystem::path& path, std::string entry, std::vector<Value> args);
+    void wait();
+    // Moves the rules of the script tree into graph in call order, keep copies them so the tree can be merged again
+    void merge(Script& script, BuildGraph& graph, bool keep = false);
+    void writeProfile(Script& script, std::ostream& report, std::ostream& stacks);
+
+    // Runs a helper script for caller and returns its entry's value, repeated calls are answered from the memo table
+    Value runScript(Script* caller, const std::filesystem::path& path, const std::string& entry, std::vector<Value> args);
+    void loadMemo(const std::filesystem::path& path);
+    void saveMemo(const std::filesystem::path& path);
+    std::vector<std::filesystem::path> loadedScripts();
+};
@@ -0,0 +1,139 @@
+#include "StatCache.h"
+#include "BuildDatabase.h"
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <unordered_set>
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+namespace {
+#ifdef _WIN32
+    FileStat fromEntry(const std::filesystem::directory_entry& entry) {
+        // On Windows the entry keeps size and time from the directory listing, no extra call is made
+        std::error_code error;
+        FileStat stat;
+        stat.size = entry.file_size(error);
+        if (error)
+            return { };
+        stat.mtime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                entry.last_write_time(error).time_since_epoch()).count();
+        if (error)
+            return { };
+        stat.exists = true;
+        return stat;
+    }
+#endif
+}
+
+FileStat StatCache::statFile(const std::string& path) {
+#ifdef _WIN32
+    std::error_code error;
+    auto entry = std::filesystem::directory_entry(path, error);
+    if (error || !entry.is_regular_file(error))
+        return { };
+    return fromEntry(entry);
+#else
+    struct stat info;
+    if (::stat(path.c_str(), &info) != 0 || !S_ISREG(info.st_mode))
+        return { };
+    FileStat stat;
+    stat.exists = true;
+    stat.size = info.st_size;
+#ifdef __APPLE__
+    stat.mtime = info.st_mtimespec.tv_sec * 1000000000ll + info.st_mtimespec.tv_nsec;
+#else
+    stat.mtime = info.st_mtim.tv_sec * 1000000000ll + info.st_mtim.tv_nsec;
+#endif
+    stat.inode = info.st_ino;
+    return stat;
+#endif
+}
+
+void StatCache::scanDirectory(const std::string& directory, const std::vector<std::string>& names) {
+    std::vector<std::pair<std::string, FileStat>> found;
+    found.reserve(names.size());
+    std::unordered_set<std::string> wanted(names.begin(), names.end());
+    std::error_code error;
+    for (auto it = std::filesystem::directory_iterator(directory, error);
+         !error && it != std::filesystem::directory_iterator(); it.increment(error))
+    {
+        auto name = it->path().filename().string();
+        if (wanted.erase(name) == 0)
+            continue;
+        auto path = (std::filesystem::path(directory) / name).string();
+#ifdef _WIN32
+        found.emplace_back(path, fromEntry(*it));
+#else
+        found.emplace_back(path, statFile(path));
+#endif
+    }
+    // Whatever the listing didn't contain is missing, no call needed
+    for (auto& name : wanted)
+        found.emplace_back((std::filesystem::path(directory) / name).string(), FileStat{ });
+
+    // Hashes survive a rescan as long as the file looks the same, which matters for the daemon
+    std::unique_lock lock(mutex);
+    for (auto& [path, stat] : found)
+    {
+        auto& entry = entries[path];
+        if (entry.stat != stat || !stat.exists)
+            entry = { stat, std::nullopt };
+    }
+}
+
+void StatCache::scan(const std::vector<std::string>& paths, ThreadPool& pool) {
+    std::map<std::string, std::vector<std::string>> directories;
+    for (auto& path : paths)
+    {
+        auto file = std::filesystem::path(path);
+        directories[file.parent_path().string()].push_back(file.filename().string());
+    }
+    for (auto& [directory, names] : directories)
+        pool.submit([this, &directory, &names]() { scanDirectory(directory, names); });
+    pool.wait();
+}
+
+FileStat StatCache::stat(const std::string& path) {
+    {
+        std::shared_lock lock(mutex);
+        if (auto it = entries.find(path); it != entries.end())
+            return it->second.stat;
+    }
+    auto stat = statFile(path);
+    std::unique_lock lock(mutex);
+    return entries.try_emplace(path, Entry{ stat, std::nullopt }).first->second.stat;
+}
+
+std::optional<uint64_t> StatCache::hash(const std::string& path) {
+    auto stat = this->stat(path);
+    if (!stat.exists)
+        return std::nullopt;
+    {
+        std::shared_lock lock(mutex);
+        if (auto it = entries.find(path); it != entries.end() && it->second.hash)
+            return it->second.hash;
+    }
+    // Two rules asking for the same file at once both hash it, the result is the same
+    auto hash = BuildDatabase::hashFile(path);
+    std::unique_lock lock(mutex);
+    if (auto it = entries.find(path); it != entries.end() && it->second.stat == stat)
+        it->second.hash = hash;
+    return hash;
+}
+
+void StatCache::invalidate(const std::string& path) {
+    std::unique_lock lock(mutex);
+    entries.erase(path);
+}
+
+bool StatCache::refresh(const std::string& path) {
+    auto stat = statFile(path);
+    std::unique_lock lock(mutex);
+    auto& entry = entries[path];
+    if (entry.stat == stat)
+        return false;
+    entry = { stat, std::nullopt };
+    return true;
+}
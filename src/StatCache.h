@@ -0,0 +1,41 @@
+#pragma once
+#include "ThreadPool.h"
+#include <cstdint>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct FileStat {
+    bool exists = false;
+    uint64_t size = 0;
+    int64_t mtime = 0; // nanoseconds
+    uint64_t inode = 0; // 0 where the platform doesn't report one
+
+    bool operator==(const FileStat&) const = default;
+};
+
+// Stat results and content hashes shared by all rules of a build. Paths are filled in bulk by scan(),
+// anything else is stat'ed on first use, and a rule's outputs are invalidated after it runs.
+class StatCache {
+    struct Entry {
+        FileStat stat;
+        std::optional<uint64_t> hash;
+    };
+
+    std::unordered_map<std::string, Entry> entries;
+    std::shared_mutex mutex;
+
+    void scanDirectory(const std::string& directory, const std::vector<std::string>& names);
+public:
+    // Lists every directory once and stats the wanted files in it, directories are spread over the pool
+    void scan(const std::vector<std::string>& paths, ThreadPool& pool);
+    FileStat stat(const std::string& path);
+    std::optional<uint64_t> hash(const std::string& path);
+    void invalidate(const std::string& path);
+    // Stats the file again, returns whether it differs from the cached result
+    bool refresh(const std::string& path);
+
+    static FileStat statFile(const std::string& path);
+};
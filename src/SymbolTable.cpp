@@ -2,23 +2,39 @@
 #include <iostream>
 #include <utility>
 
-void SymbolTable::addVariable(std::string& name, ValueID value) {
-    values[name] = value;
+void SymbolTable::addVariable(std::string_view name, ValueID value) {
+    values[std::string(name)] = value;
 }
 
-void SymbolTable::removeVariable(std::string& name) {
-    values.erase(name);
+void SymbolTable::removeVariable(std::string_view name) {
+    if (auto it = values.find(name); it != values.end())
+        values.erase(it);
 }
 
-ValueID SymbolTable::getVariable(std::string& name) {
-    if (values.contains(name))
-        return values[name];
+ValueID SymbolTable::getVariable(std::string_view name) {
+    if (auto it = values.find(name); it != values.end())
+        return it->second;
+    if (up == nullptr)
+        throw std::exception("Unknown variable");
     return up->getVariable(name);
 }
 
-void SymbolTable::setVariable(std::string& name, ValueID value) {
-    if (values.contains(name))
-        values[name] = value;
+bool SymbolTable::findVariable(std::string_view name, uint32_t& depth, ValueID& value) {
+    depth = 0;
+    for (auto table = this; table != nullptr; table = table->up.get(), depth++)
+    {
+        if (auto it = table->values.find(name); it != table->values.end())
+        {
+            value = it->second;
+            return true;
+        }
+    }
+    return false;
+}
+
+void SymbolTable::setVariable(std::string_view name, ValueID value) {
+    if (auto it = values.find(name); it != values.end())
+        it->second = value;
     else
         up->setVariable(name, value);
 }
@@ -4,19 +4,21 @@
 #include "values.h"
 #include <memory>
 #include <utility>
-#include "Memory.h"
+#include "Hash.h"
 
 class SymbolTable {
-    std::unordered_map<std::string, ValueID> values;
+    std::unordered_map<std::string, ValueID, StringHash, std::equal_to<>> values;
 public:
     std::shared_ptr<SymbolTable> up;
     SymbolTable(std::shared_ptr<SymbolTable> table) {
         up = std::move(table);
     }
     SymbolTable() = default;
-    void addVariable(std::string& name, ValueID value);
-    void removeVariable(std::string& name);
-    ValueID getVariable(std::string& name);
-    void setVariable(std::string& name, ValueID value);
+    void addVariable(std::string_view name, ValueID value);
+    void removeVariable(std::string_view name);
+    ValueID getVariable(std::string_view name);
+    bool findVariable(std::string_view name, uint32_t& depth, ValueID& value);
+    void setVariable(std::string_view name, ValueID value);
+    size_t size() { return values.size(); }
     void printValues();
 };
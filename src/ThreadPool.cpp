@@ -0,0 +1,91 @@
+#include "ThreadPool.h"
+
+thread_local ThreadPool* ThreadPool::current_pool = nullptr;
+thread_local size_t ThreadPool::current_index = 0;
+
+ThreadPool::ThreadPool(size_t count) {
+    if (count == 0)
+        count = 1;
+    for (size_t i = 0; i < count; i++)
+        workers.push_back(std::make_unique<Worker>());
+    for (size_t i = 0; i < count; i++)
+        threads.emplace_back([this, i]() { loop(i); });
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(sleep_mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& thread : threads)
+        thread.join();
+}
+
+void ThreadPool::submit(Task task) {
+    // Tasks spawned by a worker stay on its own deque, external ones are spread round-robin
+    size_t index = current_pool == this ? current_index : next_worker++ % workers.size();
+    unfinished++;
+    {
+        std::lock_guard lock(sleep_mutex);
+        queued++;
+    }
+    {
+        std::lock_guard lock(workers[index]->mutex);
+        workers[index]->tasks.push_back(std::move(task));
+    }
+    wake.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::unique_lock lock(sleep_mutex);
+    done.wait(lock, [this]() { return unfinished == 0; });
+}
+
+bool ThreadPool::pop(size_t index, Task& task) {
+    auto& worker = *workers[index];
+    std::lock_guard lock(worker.mutex);
+    if (worker.tasks.empty())
+        return false;
+    task = std::move(worker.tasks.back());
+    worker.tasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::steal(size_t index, Task& task) {
+    for (size_t k = 1; k < workers.size(); k++)
+    {
+        auto& victim = *workers[(index + k) % workers.size()];
+        std::lock_guard lock(victim.mutex);
+        if (victim.tasks.empty())
+            continue;
+        task = std::move(victim.tasks.front());
+        victim.tasks.pop_front();
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::loop(size_t index) {
+    current_pool = this;
+    current_index = index;
+    while (true)
+    {
+        Task task;
+        if (pop(index, task) || steal(index, task))
+        {
+            queued--;
+            task();
+            if (--unfinished == 0)
+            {
+                std::lock_guard lock(sleep_mutex);
+                done.notify_all();
+            }
+            continue;
+        }
+        std::unique_lock lock(sleep_mutex);
+        wake.wait(lock, [this]() { return stopping || queued > 0; });
+        if (stopping && queued == 0)
+            return;
+    }
+}
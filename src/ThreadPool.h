@@ -0,0 +1,42 @@
+#pragma once
+#include <functional>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+
+class ThreadPool {
+    using Task = std::function<void()>;
+
+    struct Worker {
+        std::deque<Task> tasks;
+        std::mutex mutex;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    std::mutex sleep_mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    std::atomic<size_t> queued = 0;
+    std::atomic<size_t> unfinished = 0;
+    std::atomic<size_t> next_worker = 0;
+    bool stopping = false;
+
+    static thread_local ThreadPool* current_pool;
+    static thread_local size_t current_index;
+
+    bool pop(size_t index, Task& task);
+    bool steal(size_t index, Task& task);
+    void loop(size_t index);
+public:
+    explicit ThreadPool(size_t count);
+    ~ThreadPool();
+
+    void submit(Task task);
+    void wait();
+    size_t size() { return workers.size(); }
+};
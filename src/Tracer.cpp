@@ -0,0 +1,54 @@
+#include "Tracer.h"
+#include <fstream>
+
+namespace {
+    void writeEscaped(std::ostream& out, const std::string& str) {
+        const char* hex = "0123456789abcdef";
+        for (unsigned char ch : str)
+        {
+            if (ch == '"' || ch == '\\')
+                out << '\\' << ch;
+            else if (ch < 0x20)
+                out << "\\u00" << hex[ch >> 4] << hex[ch & 15];
+            else
+                out << ch;
+        }
+    }
+}
+
+Tracer::Tracer() {
+    threads.emplace(std::this_thread::get_id(), 0);
+}
+
+uint64_t Tracer::now() const {
+    return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - origin).count();
+}
+
+void Tracer::record(std::string name, const char* category, uint64_t start) {
+    uint64_t end = now();
+    std::lock_guard lock(mutex);
+    auto [thread, _] = threads.try_emplace(std::this_thread::get_id(), threads.size());
+    events.push_back({ std::move(name), category, start, end - start, thread->second });
+}
+
+bool Tracer::write(const std::filesystem::path& path) {
+    std::lock_guard lock(mutex);
+    std::ofstream out(path);
+    if (!out)
+        return false;
+    out << "{\"traceEvents\":[\n";
+    for (uint32_t thread = 0; thread < threads.size(); thread++)
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread
+            << ",\"args\":{\"name\":\"" << (thread == 0 ? "main" : "thread " + std::to_string(thread)) << "\"}},\n";
+    for (size_t i = 0; i < events.size(); i++)
+    {
+        auto& event = events[i];
+        out << "{\"name\":\"";
+        writeEscaped(out, event.name);
+        out << "\",\"cat\":\"" << event.category << "\",\"ph\":\"X\",\"ts\":" << event.start
+            << ",\"dur\":" << event.duration << ",\"pid\":1,\"tid\":" << event.thread << '}';
+        out << (i + 1 < events.size() ? ",\n" : "\n");
+    }
+    out << "],\"displayTimeUnit\":\"ms\"}\n";
+    return (bool)out;
+}
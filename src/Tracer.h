@@ -0,0 +1,69 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Collects spans from any thread and writes them in the Chrome trace-event JSON format,
+// which chrome://tracing and Perfetto open directly
+class Tracer {
+    using Clock = std::chrono::steady_clock;
+
+    struct Event {
+        std::string name;
+        const char* category;
+        uint64_t start;
+        uint64_t duration;
+        uint32_t thread;
+    };
+
+    Clock::time_point origin = Clock::now();
+    std::mutex mutex;
+    std::vector<Event> events;
+    std::unordered_map<std::thread::id, uint32_t> threads; // small ids in order of first appearance
+
+public:
+    // The creating thread is reported as the main thread
+    Tracer();
+    // Microseconds since the tracer was created
+    uint64_t now() const;
+    // Records a span from start until now on the calling thread
+    void record(std::string name, const char* category, uint64_t start);
+    bool write(const std::filesystem::path& path);
+
+    // Span covering the lifetime of the object, does nothing without a tracer
+    class Span {
+        Tracer* tracer;
+        std::string name;
+        const char* category;
+        uint64_t start = 0;
+    public:
+        Span(Tracer* tracer, std::string name, const char* category) : tracer(tracer), category(category) {
+            if (tracer == nullptr)
+                return;
+            this->name = std::move(name);
+            start = tracer->now();
+        }
+        // Named prefix + subject, the name is only built when there is a tracer
+        Span(Tracer* tracer, const char* prefix, std::string_view subject, const char* category)
+            : tracer(tracer), category(category) {
+            if (tracer == nullptr)
+                return;
+            name.reserve(std::strlen(prefix) + subject.size());
+            name.append(prefix).append(subject);
+            start = tracer->now();
+        }
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+        ~Span() {
+            if (tracer != nullptr)
+                tracer->record(std::move(name), category, start);
+        }
+    };
+};
@@ -0,0 +1,250 @@
+#include "VM.h"
+#include <algorithm>
+#include <iostream>
+
+void VM::load(const ProgramView& program) {
+    registers.assign(program.registers, Value());
+    constants.clear();
+    constants.reserve(program.constants.size());
+    for (auto& c : program.constants)
+    {
+        if (c.type == ConstantType::Int)
+            constants.push_back(Value::Int(c.int_val));
+        else if (c.type == ConstantType::Float)
+            constants.push_back(Value::Float(c.float_val));
+        else if (c.type == ConstantType::Bool)
+            constants.push_back(Value::Bool(c.bool_val));
+        else
+            constants.push_back(Value::String(std::string(program.string(c.str))));
+    }
+    functions.clear();
+    for (auto& name : program.functions)
+    {
+        auto function = interpreter.functions.find(std::string(program.string(name)));
+        functions.push_back(function == interpreter.functions.end() ? nullptr : &function->second);
+    }
+    threaded.clear();
+}
+
+Value VM::call(Interpreter::Function* function, Value* args, uint16_t count, uint8_t keywords) {
+    if (function == nullptr)
+        throw std::exception("Unknown function");
+    Arguments arguments;
+    arguments.positional.assign(args, args + count);
+    for (uint8_t i = 0; i < keywords; i++)
+        arguments.keywords.emplace_back(*args[count + 2 * i].str_val, args[count + 2 * i + 1]);
+    return (*function)(&interpreter, arguments);
+}
+
+void VM::run(const ProgramView& program) {
+    load(program);
+    execute(program, 0, 0);
+}
+
+Value VM::invoke(const ProgramView& program, std::string_view name, std::vector<Value> args) {
+    for (auto& procedure : program.procedures)
+    {
+        if (program.string(procedure.name) != name)
+            continue;
+        if (args.size() != procedure.params)
+            throw std::exception("Wrong number of arguments");
+        // The result slot sits right below the callee's registers, as it does for CallProc
+        size_t base = program.registers + 1;
+        registers.resize(std::max(registers.size(), base + procedure.registers));
+        for (size_t i = 0; i < args.size(); i++)
+            registers[base + i] = std::move(args[i]);
+        return execute(program, procedure.entry, base);
+    }
+    throw std::exception("Unknown entry function");
+}
+
+Value VM::execute(const ProgramView& program, uint32_t pc, size_t base) {
+    Value* r = registers.data() + base;
+    const Value* k = constants.data();
+    const Instr* code = program.code.data();
+    const Procedure* procedures = program.procedures.data();
+    std::vector<Frame> frames;
+
+#ifdef BMAKE_THREADED_DISPATCH
+    static const void* labels[] = {
+            &&op_LoadConst, &&op_Move, &&op_LoadGlobal, &&op_StoreGlobal, &&op_Add, &&op_Sub, &&op_Mul, &&op_Div, &&op_IntDiv, &&op_Mod,
+            &&op_Eq, &&op_NotEq, &&op_Greater, &&op_Less, &&op_GreaterEq, &&op_LessEq, &&op_And, &&op_Or,
+            &&op_Neg, &&op_Not, &&op_ToBool, &&op_ToString, &&op_ToInt, &&op_ToFloat, &&op_MakeList,
+            &&op_Call, &&op_CallProc, &&op_Return, &&op_Jump, &&op_JumpIfFalse, &&op_JumpIfTrue, &&op_Halt,
+    };
+    static_assert(std::size(labels) == (size_t)OpCode::Last);
+    // Direct threading: every instruction gets the address of its handler up front
+    if (threaded.size() != program.code.size())
+    {
+        threaded.resize(program.code.size());
+        for (size_t i = 0; i < program.code.size(); i++)
+            threaded[i] = labels[(int)program.code[i].op];
+    }
+#define VM_CASE(name) op_##name:
+#define VM_DISPATCH() goto *threaded[pc]
+#else
+#define VM_CASE(name) case OpCode::name:
+#define VM_DISPATCH() goto dispatch
+#endif
+#define VM_NEXT() do { pc++; VM_DISPATCH(); } while (false)
+#define VM_JUMP(target) do { pc = (target); VM_DISPATCH(); } while (false)
+#define VM_BINARY(name, int_result) \
+    VM_CASE(name) { \
+        const Instr& in = code[pc]; \
+        const Value& x = r[in.b]; \
+        const Value& y = r[in.c]; \
+        if (x.type == ValueType::Int && y.type == ValueType::Int) { \
+            int lhs = x.int_val; \
+            int rhs = y.int_val; \
+            r[in.a] = int_result; \
+        } \
+        else \
+            r[in.a] = interpreter.DoBinOp(x, y, ExprType::name); \
+        VM_NEXT(); \
+    }
+
+#ifdef BMAKE_THREADED_DISPATCH
+    VM_DISPATCH();
+#else
+dispatch:
+    switch (code[pc].op) {
+#endif
+    VM_CASE(LoadConst) {
+        r[code[pc].a] = k[code[pc].bx()];
+        VM_NEXT();
+    }
+    VM_CASE(Move) {
+        r[code[pc].a] = r[code[pc].b];
+        VM_NEXT();
+    }
+    VM_CASE(LoadGlobal) {
+        r[code[pc].a] = registers[code[pc].bx()];
+        VM_NEXT();
+    }
+    VM_CASE(StoreGlobal) {
+        registers[code[pc].bx()] = r[code[pc].a];
+        VM_NEXT();
+    }
+    VM_BINARY(Add, Value::Int(lhs + rhs))
+    VM_BINARY(Sub, Value::Int(lhs - rhs))
+    VM_BINARY(Mul, Value::Int(lhs * rhs))
+    VM_BINARY(Div, Value::Float((float)lhs / (float)rhs))
+    VM_BINARY(IntDiv, Value::Int((float)lhs / (float)rhs))
+    VM_BINARY(Mod, Value::Int(lhs % rhs))
+    VM_BINARY(Eq, Value::Bool((lhs != 0) == (rhs != 0)))
+    VM_BINARY(NotEq, Value::Bool((lhs != 0) != (rhs != 0)))
+    VM_BINARY(Greater, Value::Bool((float)lhs > (float)rhs))
+    VM_BINARY(Less, Value::Bool((float)lhs < (float)rhs))
+    VM_BINARY(GreaterEq, Value::Bool((float)lhs >= (float)rhs))
+    VM_BINARY(LessEq, Value::Bool((float)lhs <= (float)rhs))
+    VM_BINARY(And, Value::Bool(lhs && rhs))
+    VM_BINARY(Or, Value::Bool(lhs || rhs))
+    VM_CASE(Neg) {
+        Value& v = r[code[pc].b];
+        if (v.IsInteger())
+            r[code[pc].a] = Value::Int(-v.ToInt());
+        else if (v.type == ValueType::Float)
+            r[code[pc].a] = Value::Float(-v.float_val);
+        else
+            throw std::exception("Wrong operand type");
+        VM_NEXT();
+    }
+    VM_CASE(Not) {
+        Value& v = r[code[pc].b];
+        if (!v.IsNumeric())
+            throw std::exception("Wrong operand type");
+        r[code[pc].a] = Value::Bool(!v.ToBool());
+        VM_NEXT();
+    }
+    VM_CASE(ToBool) {
+        Value& v = r[code[pc].b];
+        if (!v.IsNumeric())
+            throw std::exception("Wrong operand type");
+        r[code[pc].a] = Value::Bool(v.ToBool());
+        VM_NEXT();
+    }
+    VM_CASE(ToString) {
+        r[code[pc].a] = Value::String(r[code[pc].b].ToString());
+        VM_NEXT();
+    }
+    VM_CASE(ToInt) {
+        Value& v = r[code[pc].b];
+        if (!v.IsNumeric())
+            throw std::exception("Wrong operand type");
+        r[code[pc].a] = Value::Int(v.ToInt());
+        VM_NEXT();
+    }
+    VM_CASE(ToFloat) {
+        Value& v = r[code[pc].b];
+        if (!v.IsNumeric())
+            throw std::exception("Wrong operand type");
+        r[code[pc].a] = Value::Float(v.ToFloat());
+        VM_NEXT();
+    }
+    VM_CASE(MakeList) {
+        const Instr& in = code[pc];
+        std::vector<Value> items(r + in.b, r + in.b + in.c);
+        r[in.a] = Value::List(std::move(items));
+        VM_NEXT();
+    }
+    VM_CASE(Call) {
+        const Instr& in = code[pc];
+        r[in.a] = call(functions[in.b], r + in.a + 1, in.c, in.d);
+        VM_NEXT();
+    }
+    VM_CASE(CallProc) {
+        const Instr& in = code[pc];
+        const Procedure& procedure = procedures[in.b];
+        if (in.c != procedure.params)
+            throw std::exception("Wrong number of arguments");
+        frames.push_back({ pc + 1, base });
+        base += in.a + 1;
+        if (registers.size() < base + procedure.registers)
+            registers.resize(base + procedure.registers);
+        r = registers.data() + base;
+        VM_JUMP(procedure.entry);
+    }
+    VM_CASE(Return) {
+        Value result = std::move(r[code[pc].a]);
+        registers[base - 1] = std::move(result);
+        if (frames.empty())
+            return registers[base - 1];
+        pc = frames.back().return_pc;
+        base = frames.back().base;
+        frames.pop_back();
+        r = registers.data() + base;
+        VM_DISPATCH();
+    }
+    VM_CASE(Jump) {
+        VM_JUMP(code[pc].bx());
+    }
+    VM_CASE(JumpIfFalse) {
+        if (!r[code[pc].a].ToBool())
+            VM_JUMP(code[pc].bx());
+        VM_NEXT();
+    }
+    VM_CASE(JumpIfTrue) {
+        if (r[code[pc].a].ToBool())
+            VM_JUMP(code[pc].bx());
+        VM_NEXT();
+    }
+    VM_CASE(Halt) {
+        return Value();
+    }
+#ifndef BMAKE_THREADED_DISPATCH
+    default:
+        throw std::exception("Unknown instruction");
+    }
+#endif
+#undef VM_BINARY
+#undef VM_JUMP
+#undef VM_NEXT
+#undef VM_DISPATCH
+#undef VM_CASE
+}
+
+void VM::print(const ProgramView& program) {
+    std::cout << "Variables:\n";
+    for (auto& symbol : program.globals)
+        std::cout << program.string(symbol.name) << '\t' << registers[symbol.reg] << '\n';
+}
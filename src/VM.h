@@ -0,0 +1,31 @@
+#pragma once
+#include "Bytecode.h"
+#include "Interpreter.h"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define BMAKE_THREADED_DISPATCH
+#endif
+
+class VM {
+    Interpreter& interpreter;
+    std::vector<Value> registers;
+    std::vector<Value> constants;
+    std::vector<Interpreter::Function*> functions;
+    std::vector<const void*> threaded;
+
+    struct Frame {
+        uint32_t return_pc;
+        size_t base;
+    };
+
+    void load(const ProgramView& program);
+    Value call(Interpreter::Function* function, Value* args, uint16_t count, uint8_t keywords);
+    Value execute(const ProgramView& program, uint32_t pc, size_t base);
+public:
+    explicit VM(Interpreter& interpreter) : interpreter(interpreter) { }
+
+    void run(const ProgramView& program);
+    // Calls a script function after run() has initialized the globals
+    Value invoke(const ProgramView& program, std::string_view name, std::vector<Value> args);
+    void print(const ProgramView& program);
+};
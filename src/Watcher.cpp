@@ -0,0 +1,277 @@
+#include "Watcher.h"
+#include "constants.h"
+#include "Executor.h"
+#include <iostream>
+#ifdef __linux__
+#include <cerrno>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    std::string normalize(const std::filesystem::path& path) {
+        return path.lexically_normal().string();
+    }
+}
+
+Watcher::Watcher(const ProgramArguments& args, const std::filesystem::path& directory)
+    : args(args), directory(directory), database((directory / build_database_name).string()) {
+    database.load();
+    if (args.cache)
+        cache = std::make_unique<OutputCache>(OutputCache::defaultDirectory(), args.cache_size << 20);
+    if (!args.remote_cache.empty())
+        remote = std::make_unique<RemoteCache>(args.remote_cache);
+}
+
+void Watcher::configure() {
+    root = nullptr;
+    loader = std::make_unique<ScriptLoader>(args.jobs, args.tree_walk);
+    if (args.memo)
+        loader->loadMemo(directory / run_script_memo_name);
+    try {
+        root = loader->load(directory / script_default_name);
+        loader->wait();
+    }
+    catch (...) {
+        loader->wait();
+        rememberScripts();
+        throw;
+    }
+    rememberScripts();
+    if (args.memo)
+        loader->saveMemo(directory / run_script_memo_name);
+    link();
+}
+
+void Watcher::reload(Script& script, const std::unordered_set<std::string>& changed, size_t& found) {
+    if (changed.contains(normalize(script.path)))
+    {
+        // Children are spawned again by the script itself
+        found++;
+        loader->reload(script, &script == root.get());
+        return;
+    }
+    for (auto& child : script.children)
+        reload(*child, changed, found);
+}
+
+bool Watcher::reloadScripts(const std::unordered_set<std::string>& changed) {
+    if (root == nullptr)
+        return false;
+    size_t found = 0;
+    reload(*root, changed, found);
+    loader->wait();
+    // A changed script that isn't in the tree is a run_script() helper, its callers are unknown
+    if (found != changed.size())
+        return false;
+    rememberScripts();
+    link();
+    return true;
+}
+
+void Watcher::rememberScripts() {
+    scripts.clear();
+    for (auto& path : loader->loadedScripts())
+    {
+        scripts[normalize(path)] = StatCache::statFile(path.string());
+        watch(path.parent_path());
+    }
+}
+
+void Watcher::link() {
+    // The previous graph stays in use until the new one is complete
+    BuildGraph merged;
+    merged.directory = directory;
+    loader->merge(*root, merged, true);
+    merged.link();
+    graph = std::move(merged);
+    users.clear();
+    for (size_t i = 0; i < graph.size(); i++)
+    {
+        auto& rule = graph.rule(i);
+        for (auto files : { &rule.inputs, &rule.outputs })
+        {
+            for (auto& file : *files)
+            {
+                auto path = BuildDatabase::filePath(rule, file);
+                users[path].push_back(i);
+                watch(std::filesystem::path(path).parent_path());
+            }
+        }
+    }
+}
+
+void Watcher::build(const std::vector<bool>* dirty) {
+    // A failed build stops early, so the rules it skipped are only found by checking everything
+    if (incomplete)
+        dirty = nullptr;
+    incomplete = true;
+    auto executor = Executor(args.jobs, &database, nullptr, cache.get(), remote.get());
+    incomplete = !executor.run(graph, dirty);
+    database.save();
+    if (cache != nullptr)
+        cache->trim();
+    // Events caused by the rules' own writes are recognized by their stats matching the cache
+    for (size_t i = 0; i < graph.size(); i++)
+    {
+        if (dirty != nullptr && !(*dirty)[i])
+            continue;
+        auto& rule = graph.rule(i);
+        for (auto& output : rule.outputs)
+            database.refresh(BuildDatabase::filePath(rule, output));
+        // Output directories may have been created just now
+        for (auto& output : rule.outputs)
+            watch(std::filesystem::path(BuildDatabase::filePath(rule, output)).parent_path());
+    }
+}
+
+#ifdef __linux__
+Watcher::~Watcher() {
+    if (inotify >= 0)
+        close(inotify);
+}
+
+void Watcher::watch(const std::filesystem::path& path) {
+    auto directory = normalize(path);
+    if (watched.contains(directory))
+        return;
+    uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_ATTRIB;
+    int descriptor = inotify_add_watch(inotify, directory.c_str(), mask);
+    if (descriptor < 0)
+        return;
+    watched.insert(directory);
+    watches[descriptor] = directory;
+}
+
+std::unordered_set<std::string> Watcher::wait() {
+    std::unordered_set<std::string> changed;
+    alignas(inotify_event) char buffer[64 * 1024];
+    // Blocks until the first event, then collects until nothing arrives for a moment, so a save touching
+    // several files ends up in one build
+    int timeout = -1;
+    while (true)
+    {
+        pollfd descriptor = { inotify, POLLIN, 0 };
+        int ready = poll(&descriptor, 1, timeout);
+        if (ready == 0)
+            return changed;
+        if (ready < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            throw std::exception("Can't wait for file events");
+        }
+        ssize_t size = read(inotify, buffer, sizeof(buffer));
+        for (ssize_t offset = 0; offset < size; )
+        {
+            auto event = reinterpret_cast<inotify_event*>(buffer + offset);
+            offset += sizeof(inotify_event) + event->len;
+            if (event->mask & IN_Q_OVERFLOW)
+                overflowed = true;
+            if (event->mask & IN_IGNORED)
+            {
+                watched.erase(watches[event->wd]);
+                watches.erase(event->wd);
+                continue;
+            }
+            if (auto it = watches.find(event->wd); it != watches.end() && event->len != 0)
+                changed.insert(normalize(std::filesystem::path(it->second) / event->name));
+        }
+        timeout = 50;
+    }
+}
+
+int Watcher::run() {
+    inotify = inotify_init1(IN_CLOEXEC);
+    if (inotify < 0)
+    {
+        std::cout << "Can't initialize inotify\n";
+        return 1;
+    }
+    try {
+        configure();
+        build(nullptr);
+    }
+    catch (std::exception& e) {
+        std::cout << e.what() << '\n';
+    }
+
+    bool announce = true;
+    while (true)
+    {
+        if (announce)
+            std::cout << "Watching for changes" << std::endl;
+        announce = false;
+        auto changed = wait();
+        try {
+            std::unordered_set<std::string> changed_scripts;
+            for (auto& path : changed)
+                if (auto it = scripts.find(path); it != scripts.end() && StatCache::statFile(path) != it->second)
+                    changed_scripts.insert(path);
+            if (!changed_scripts.empty())
+            {
+                announce = true;
+                if (!reloadScripts(changed_scripts))
+                    configure();
+                build(nullptr);
+                continue;
+            }
+            if (overflowed)
+            {
+                overflowed = false;
+                announce = true;
+                build(nullptr);
+                continue;
+            }
+
+            std::vector<bool> dirty(graph.size());
+            std::vector<size_t> stack;
+            for (auto& path : changed)
+            {
+                auto it = users.find(path);
+                if (it == users.end() || !database.refresh(path))
+                    continue;
+                for (auto i : it->second)
+                    if (!dirty[i])
+                    {
+                        dirty[i] = true;
+                        stack.push_back(i);
+                    }
+            }
+            if (stack.empty())
+                continue;
+            announce = true;
+            while (!stack.empty())
+            {
+                size_t i = stack.back();
+                stack.pop_back();
+                for (auto dependent : graph.rule(i).dependents)
+                    if (!dirty[dependent])
+                    {
+                        dirty[dependent] = true;
+                        stack.push_back(dependent);
+                    }
+            }
+            build(&dirty);
+        }
+        catch (std::exception& e) {
+            std::cout << e.what() << '\n';
+            announce = true;
+        }
+    }
+}
+#else
+Watcher::~Watcher() { }
+
+void Watcher::watch(const std::filesystem::path&) { }
+
+std::unordered_set<std::string> Watcher::wait() {
+    return { };
+}
+
+int Watcher::run() {
+    std::cout << "--watch needs inotify, which is only available on Linux\n";
+    return 1;
+}
+#endif
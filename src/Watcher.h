@@ -0,0 +1,52 @@
+#pragma once
+#include "args_parser.h"
+#include "BuildGraph.h"
+#include "BuildDatabase.h"
+#include "OutputCache.h"
+#include "RemoteCache.h"
+#include "ScriptLoader.h"
+#include "StatCache.h"
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// --watch: builds once, then waits for inotify events in the directories of rule files and scripts.
+// A changed file marks the rules reading or writing it and everything depending on them dirty, and only
+// those are checked and rebuilt. A changed script is evaluated again on its own, together with the
+// subdirectory() calls it makes; a changed run_script() helper means evaluating everything again.
+class Watcher {
+    ProgramArguments args;
+    std::filesystem::path directory;
+    BuildDatabase database;
+    std::unique_ptr<OutputCache> cache; // only with --cache
+    std::unique_ptr<RemoteCache> remote; // only with --remote-cache
+    std::unique_ptr<ScriptLoader> loader;
+    std::shared_ptr<Script> root;
+    BuildGraph graph;
+    std::unordered_map<std::string, FileStat> scripts;
+    std::unordered_map<std::string, std::vector<size_t>> users; // rules reading or writing each file
+    int inotify = -1;
+    std::unordered_map<int, std::string> watches; // watch descriptor -> directory
+    std::unordered_set<std::string> watched;
+    bool overflowed = false; // the kernel dropped events, everything has to be checked
+    bool incomplete = false; // the last build failed, rules it didn't get to have to be checked again
+
+    void configure();
+    bool reloadScripts(const std::unordered_set<std::string>& changed);
+    void reload(Script& script, const std::unordered_set<std::string>& changed, size_t& found);
+    void rememberScripts();
+    void link();
+    void watch(const std::filesystem::path& path);
+    std::unordered_set<std::string> wait();
+    void build(const std::vector<bool>* dirty);
+public:
+    Watcher(const ProgramArguments& args, const std::filesystem::path& directory);
+    ~Watcher();
+    Watcher(const Watcher&) = delete;
+    Watcher& operator=(const Watcher&) = delete;
+
+    int run();
+};
@@ -1,10 +1,24 @@
 #include "args_parser.h"
 #include <iostream>
+#include <thread>
 
 ProgramArguments ArgumentsParser::parse(int argc, char **argv) {
     ProgramArguments args = {
             .success = false,
             .current_directory = std::filesystem::current_path(),
+            .jobs = std::max(1u, std::thread::hardware_concurrency()),
+            .tree_walk = false,
+            .memo = false,
+            .profile = false,
+            .trace = {},
+            .daemon = false,
+            .client = false,
+            .stop_daemon = false,
+            .watch = false,
+            .cache = false,
+            .cache_size = 2048,
+            .remote_cache = {},
+            .cache_server = 0,
     };
 
     int i = 1;
@@ -15,6 +29,46 @@ ProgramArguments ArgumentsParser::parse(int argc, char **argv) {
             if (arg == "-s") {
                 state = GetCurrentDirectory;
             }
+            else if (arg == "-j") {
+                state = GetJobs;
+            }
+            else if (arg == "--tree-walk") {
+                args.tree_walk = true;
+            }
+            else if (arg == "--memo") {
+                args.memo = true;
+            }
+            else if (arg == "--profile") {
+                args.profile = true;
+            }
+            else if (arg == "--trace") {
+                state = GetTrace;
+            }
+            else if (arg == "--daemon") {
+                args.daemon = true;
+            }
+            else if (arg == "--client") {
+                args.client = true;
+            }
+            else if (arg == "--stop-daemon") {
+                args.stop_daemon = true;
+            }
+            else if (arg == "--watch") {
+                args.watch = true;
+            }
+            else if (arg == "--cache") {
+                args.cache = true;
+            }
+            else if (arg == "--cache-size") {
+                args.cache = true;
+                state = GetCacheSize;
+            }
+            else if (arg == "--remote-cache") {
+                state = GetRemoteCache;
+            }
+            else if (arg == "--cache-server") {
+                state = GetCacheServer;
+            }
             else
                 break;
         }
@@ -22,15 +76,55 @@ ProgramArguments ArgumentsParser::parse(int argc, char **argv) {
             args.current_directory = arg;
             state = Idle;
         }
+        else if (state == GetJobs) {
+            if (arg.empty() || arg.find_first_not_of("0123456789") != std::string::npos || std::stoul(arg) == 0)
+                break;
+            args.jobs = std::stoul(arg);
+            state = Idle;
+        }
+        else if (state == GetTrace) {
+            args.trace = arg;
+            state = Idle;
+        }
+        else if (state == GetCacheSize) {
+            if (arg.empty() || arg.find_first_not_of("0123456789") != std::string::npos)
+                break;
+            args.cache_size = std::stoull(arg);
+            state = Idle;
+        }
+        else if (state == GetRemoteCache) {
+            args.remote_cache = arg;
+            state = Idle;
+        }
+        else if (state == GetCacheServer) {
+            if (arg.empty() || arg.size() > 5 || arg.find_first_not_of("0123456789") != std::string::npos
+                || std::stoul(arg) == 0 || std::stoul(arg) > 65535)
+                break;
+            args.cache_server = std::stoul(arg);
+            state = Idle;
+        }
     }
     if (i == argc && state == Idle)
         args.success = true;
     else
         printUsage();
-    return std::move(args);
+    return args;
 }
 
 void ArgumentsParser::printUsage() {
     std::cout << "Usage:\n";
     std::cout << "\t-s\tSet current directory\n";
+    std::cout << "\t-j N\tRun up to N rules in parallel\n";
+    std::cout << "\t--tree-walk\tEvaluate the script with the AST interpreter instead of the bytecode VM\n";
+    std::cout << "\t--memo\tKeep run_script() results between runs\n";
+    std::cout << "\t--profile\tPrint time spent per script line and node, write collapsed stacks for flame graphs\n";
+    std::cout << "\t--trace FILE\tWrite configure phases and rule runs as Chrome trace events\n";
+    std::cout << "\t--daemon\tStay resident and serve builds, scripts are evaluated again only when they change\n";
+    std::cout << "\t--client\tBuild through the daemon running for the script directory\n";
+    std::cout << "\t--stop-daemon\tStop the daemon running for the script directory\n";
+    std::cout << "\t--watch\tBuild, then rebuild whatever depends on files and scripts as they change\n";
+    std::cout << "\t--cache\tRestore rule outputs from the shared output cache ($BMAKE_CACHE_DIR or ~/.cache/bmake)\n";
+    std::cout << "\t--cache-size MB\tUse the output cache and keep it under MB megabytes (2048 by default)\n";
+    std::cout << "\t--remote-cache URL\tLook up and upload rule outputs at an HTTP cache, e.g. http://127.0.0.1:8080\n";
+    std::cout << "\t--cache-server PORT\tServe a reference remote cache on 127.0.0.1:PORT\n";
 }
\ No newline at end of file
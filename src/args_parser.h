@@ -1,11 +1,25 @@
 #pragma once
 #include <string>
 #include <filesystem>
+#include <cstdint>
 
 struct ProgramArguments
 {
     bool success;
     std::filesystem::path current_directory;
+    unsigned int jobs;
+    bool tree_walk;
+    bool memo;
+    bool profile;
+    std::filesystem::path trace; // empty unless --trace was given
+    bool daemon;
+    bool client;
+    bool stop_daemon;
+    bool watch;
+    bool cache;
+    uint64_t cache_size; // MiB
+    std::string remote_cache; // URL, empty when not used
+    unsigned int cache_server; // port to serve a remote cache on, 0 when not serving
 };
 
 class ArgumentsParser
@@ -13,6 +27,11 @@ class ArgumentsParser
     enum state {
         Idle,
         GetCurrentDirectory,
+        GetJobs,
+        GetTrace,
+        GetCacheSize,
+        GetRemoteCache,
+        GetCacheServer,
     } state = Idle;
 
     void printUsage();
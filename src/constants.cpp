@@ -1,4 +1,9 @@
 #include "constants.h"
 #include "constants.h"
 
-std::string script_default_name = "script.bm";
\ No newline at end of file
+std::string script_default_name = "script.bm";
+std::string build_database_name = ".bmake_db";
+std::string script_cache_suffix = ".bmake_cache";
+std::string run_script_memo_name = ".bmake_memo";
+std::string profile_stacks_name = "bmake_profile.folded";
+std::string daemon_socket_name = ".bmake_sock";
\ No newline at end of file
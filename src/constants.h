@@ -1,4 +1,9 @@
 #pragma once
 #include <string>
 
-extern std::string script_default_name;
\ No newline at end of file
+extern std::string script_default_name;
+extern std::string build_database_name;
+extern std::string script_cache_suffix;
+extern std::string run_script_memo_name;
+extern std::string profile_stacks_name;
+extern std::string daemon_socket_name;
@@ -1,29 +1,103 @@
+#include <fstream>
 #include <iostream>
+#include <memory>
 #include <string>
 #include "args_parser.h"
+#include "CacheServer.h"
 #include "constants.h"
-#include <fstream>
-#include "Lexer.h"
-#include "Parser.h"
-#include "Interpreter.h"
+#include "Daemon.h"
+#include "Executor.h"
+#include "ScriptLoader.h"
+#include "Watcher.h"
 
 int main(int argc, char* argv[]) {
     auto args_parser = ArgumentsParser();
     ProgramArguments args = args_parser.parse(argc, argv);
     if (!args.success)
         return 0;
+    if (args.cache_server != 0)
+        return CacheServer(OutputCache::defaultDirectory() / "server").serve(args.cache_server);
+
+    std::filesystem::path script_directory = std::filesystem::absolute(args.current_directory);
+    std::filesystem::path path_to_script = script_directory / script_default_name;
+    if (!std::filesystem::is_regular_file(path_to_script))
+    {
+        std::cout << "Can't open " << path_to_script.string() << '\n';
+        return 1;
+    }
+
+    auto socket_path = script_directory / daemon_socket_name;
+    if (args.client || args.stop_daemon)
+        return Daemon::request(socket_path, args.stop_daemon ? "stop" : "build");
+    if (args.daemon)
+        return Daemon(args, script_directory).serve(socket_path);
+    if (args.watch)
+        return Watcher(args, script_directory).run();
+
+    std::unique_ptr<Tracer> tracer;
+    if (!args.trace.empty())
+        tracer = std::make_unique<Tracer>();
 
-    std::filesystem::path path_to_script = args.current_directory.append(script_default_name);
-    std::ifstream inputFile(path_to_script);
-    std::string code((std::istreambuf_iterator<char>(inputFile)), (std::istreambuf_iterator<char>()));
-    inputFile.close();
+    BuildGraph graph;
+    graph.directory = script_directory;
+    {
+        Tracer::Span span(tracer.get(), "configure", "configure");
+        ScriptLoader loader(args.jobs, args.tree_walk, args.profile, tracer.get());
+        if (args.memo)
+            loader.loadMemo(script_directory / run_script_memo_name);
+        auto root = loader.load(path_to_script);
+        {
+            Tracer::Span span(tracer.get(), "wait for subdirectories", "configure");
+            loader.wait();
+        }
+        loader.merge(*root, graph);
+        if (args.profile)
+        {
+            auto stacks_path = script_directory / profile_stacks_name;
+            std::ofstream stacks(stacks_path);
+            loader.writeProfile(*root, std::cout, stacks);
+            std::cout << "Collapsed stacks written to " << stacks_path.string() << '\n';
+        }
+        if (args.memo)
+            loader.saveMemo(script_directory / run_script_memo_name);
+    }
 
-    auto lexer = Lexer();
-    auto token_list = lexer.tokenize(code);
-    auto parser = Parser();
-    auto ast = parser.getAST(token_list);
-    std::cout << "Parsed\n";
-    auto interpreter = Interpreter();
-    interpreter.exec(ast.get());
-    interpreter.memory.print();
+    BuildDatabase database((script_directory / build_database_name).string());
+    {
+        Tracer::Span span(tracer.get(), "load database", "database");
+        database.load();
+    }
+    std::unique_ptr<OutputCache> cache;
+    if (args.cache)
+        cache = std::make_unique<OutputCache>(OutputCache::defaultDirectory(), args.cache_size << 20);
+    std::unique_ptr<RemoteCache> remote;
+    if (!args.remote_cache.empty())
+    {
+        try {
+            remote = std::make_unique<RemoteCache>(args.remote_cache);
+        }
+        catch (std::exception& e) {
+            std::cout << e.what() << '\n';
+            return 1;
+        }
+    }
+    auto executor = Executor(args.jobs, &database, tracer.get(), cache.get(), remote.get());
+    bool success;
+    {
+        Tracer::Span span(tracer.get(), "build", "build");
+        success = executor.run(graph);
+    }
+    {
+        Tracer::Span span(tracer.get(), "save database", "database");
+        database.save();
+    }
+    if (cache != nullptr)
+    {
+        Tracer::Span span(tracer.get(), "trim output cache", "cache");
+        cache->trim();
+    }
+    if (tracer != nullptr && !tracer->write(args.trace))
+        std::cout << "Can't write trace " << args.trace.string() << '\n';
+    if (!success)
+        return 1;
 }
@@ -1,8 +1,11 @@
 #pragma once
+#include <algorithm>
 #include <string>
-#include <optional>
+#include <string_view>
+#include <vector>
+#include <cstdint>
 
-enum class TokenType {
+enum class TokenType : uint8_t {
     IntegerLiteral, // 8909
     StringLiteral, // "str"
     FloatLiteral, // 45.7
@@ -61,105 +64,87 @@ enum class TokenType {
     Const,
     Foreach,
     Fn,
+    Return,
 };
 
 struct Token {
     TokenType type;
-    std::optional<int> int_val;
-    std::optional<float> float_val;
-    std::optional<std::string> string_val;
-    std::optional<bool> bool_val;
+    uint32_t offset; // position of the token in the source
+    uint32_t length;
+    union {
+        int int_val;
+        float float_val;
+        bool bool_val;
+        uint32_t string_index; // index into TokenList::strings, no_string if the text is taken from the source
+    };
 
-    Token() {
-        this->type = TokenType::Error;
-    }
+    static constexpr uint32_t no_string = UINT32_MAX;
 
-    Token(TokenType type) {
-        this->type = type;
-    }
+    Token() : Token(TokenType::Error) { }
 
-    Token(TokenType type, std::optional<int> int_val, std::optional<float> float_val,
-          std::optional<std::string> string_val, std::optional<bool> bool_val) {
+    Token(TokenType type, uint32_t offset = 0, uint32_t length = 0) {
         this->type = type;
-        this->int_val = int_val;
-        this->float_val = float_val;
-        this->string_val = string_val;
-        this->bool_val = bool_val;
+        this->offset = offset;
+        this->length = length;
+        this->string_index = no_string;
     }
 
-    bool operator==(Token token)
-    {
-        return type == token.type && int_val == token.int_val && float_val == token.float_val &&
-            string_val == token.string_val && bool_val == token.bool_val;
+    bool operator==(const Token& token) const {
+        return type == token.type && offset == token.offset && length == token.length && string_index == token.string_index;
     }
 
-    static Token FloatLiteral(float value) {
-        return {
-            TokenType::FloatLiteral,
-            std::nullopt,
-            value,
-            std::nullopt,
-            std::nullopt
-        };
+    static Token FloatLiteral(float value, uint32_t offset, uint32_t length) {
+        Token token(TokenType::FloatLiteral, offset, length);
+        token.float_val = value;
+        return token;
     }
 
-    static Token IntegerLiteral(int value) {
-        return {
-                TokenType::IntegerLiteral,
-                value,
-                std::nullopt,
-                std::nullopt,
-                std::nullopt
-        };
+    static Token IntegerLiteral(int value, uint32_t offset, uint32_t length) {
+        Token token(TokenType::IntegerLiteral, offset, length);
+        token.int_val = value;
+        return token;
     }
 
-    static Token StringLiteral(std::string value) {
-        return {
-                TokenType::StringLiteral,
-                std::nullopt,
-                std::nullopt,
-                value,
-                std::nullopt
-        };
+    static Token BoolLiteral(bool value, uint32_t offset = 0, uint32_t length = 0) {
+        Token token(TokenType::BoolLiteral, offset, length);
+        token.bool_val = value;
+        return token;
     }
+};
 
-    static Token BoolLiteral(bool value) {
-        return {
-                TokenType::BoolLiteral,
-                std::nullopt,
-                std::nullopt,
-                std::nullopt,
-                value
-        };
-    }
+static_assert(sizeof(Token) == 16);
+
+// Tokens reference the source buffer, which must outlive the list.
+// Only string literals with escapes and error messages own their text.
+struct TokenList {
+    std::string_view source;
+    std::vector<Token> tokens;
+    std::vector<std::string> strings;
+    std::vector<uint32_t> line_starts; // offset of every line, positions are derived from token offsets
 
-    static Token Identifier(std::string value) {
-        return {
-                TokenType::Identifier,
-                std::nullopt,
-                std::nullopt,
-                value,
-                std::nullopt
-        };
+    void indexLines() {
+        line_starts.assign(1, 0);
+        for (size_t i = source.find('\n'); i != std::string_view::npos; i = source.find('\n', i + 1))
+            line_starts.push_back(i + 1);
     }
 
-    static Token Error(std::string value) {
-        return {
-                TokenType::Error,
-                std::nullopt,
-                std::nullopt,
-                value,
-                std::nullopt
-        };
+    // 1-based line and column of a source offset
+    void position(uint32_t offset, uint32_t& line, uint32_t& column) const {
+        auto next = std::upper_bound(line_starts.begin(), line_starts.end(), offset);
+        line = next - line_starts.begin();
+        column = offset - *(next - 1) + 1;
     }
 
-    static Token NonTerminal(std::string value) {
-        return {
-                TokenType::NonTerminal,
-                std::nullopt,
-                std::nullopt,
-                value,
-                std::nullopt
-        };
+    std::string_view text(const Token& token) const {
+        if (token.type == TokenType::StringLiteral || token.type == TokenType::Error)
+        {
+            if (token.string_index != Token::no_string)
+                return strings[token.string_index];
+            if (token.type == TokenType::StringLiteral)
+                return source.substr(token.offset + 1, token.length - 2);
+        }
+        return source.substr(token.offset, token.length);
     }
-};
\ No newline at end of file
+
+    size_t size() const { return tokens.size(); }
+};
@@ -1,12 +1,17 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <memory>
 #include <optional>
-#include "Memory.h"
+#include <vector>
+#include <ostream>
+
+using ValueID = unsigned long long;
 
 enum class ValueType {
     Int, Reference, Bool, Float,
-    String,
+    String, List,
+    Last,
 };
 
 class Value
@@ -20,58 +25,45 @@ public:
         bool bool_val;
         ValueID reference;
         std::string* str_val = nullptr;
+        std::vector<Value>* list_val;
     };
 
-    Value() { }
+    Value() {
+        type = ValueType::Int;
+    }
 
     ~Value() {
-        if (type == ValueType::String)
-            delete str_val;
+        release();
     }
 
     Value(const Value& other) {
         type = other.type;
-        if (type == ValueType::String)
-            str_val = new std::string(*other.str_val);
-        else
-            copy = other.copy;
+        copyFrom(other);
     }
 
     Value& operator=(const Value& other) {
         if (this != &other) {
-            if (type == ValueType::String)
-                delete str_val;
+            release();
             type = other.type;
-            if (type == ValueType::String)
-                str_val = new std::string(*other.str_val);
-            else
-                copy = other.copy;
+            copyFrom(other);
         }
         return *this;
     }
 
     Value(Value&& other) noexcept {
         type = other.type;
-        if (type == ValueType::String)
-        {
-            str_val = other.str_val;
-            other.str_val = nullptr;
-        }
-        else copy = other.copy;
+        copy = other.copy;
+        other.copy = 0;
+        other.type = ValueType::Int;
     }
 
     Value& operator=(Value&& other) noexcept {
         if (this != &other) {
-            if (type == ValueType::String)
-                delete str_val;
+            release();
             type = other.type;
-            if (type == ValueType::String)
-            {
-                str_val = other.str_val;
-                other.str_val = nullptr;
-            }
-            else
-                copy = other.copy;
+            copy = other.copy;
+            other.copy = 0;
+            other.type = ValueType::Int;
         }
         return *this;
     }
@@ -80,31 +72,61 @@ public:
         Value val;
         val.type = ValueType::Int;
         val.int_val = value;
-        return std::move(val);
+        return val;
     }
 
     static Value Float(float value) {
         Value val;
         val.type = ValueType::Float;
         val.float_val = value;
-        return std::move(val);
+        return val;
     }
 
     static Value Bool(bool value) {
         Value val;
         val.type = ValueType::Bool;
         val.bool_val = value;
-        return std::move(val);
+        return val;
     }
 
-    static std::unique_ptr<Value> String(std::string& value) {
-        auto val = std::make_unique<Value>();
-        val->type = ValueType::String;
-        val->str_val = new std::string(value);
+    static Value String(std::string_view value) {
+        Value val;
+        val.type = ValueType::String;
+        val.str_val = new std::string(value);
         return val;
     }
 
-    float ToFloat() {
+    static Value List(std::vector<Value> items) {
+        Value val;
+        val.type = ValueType::List;
+        val.list_val = new std::vector<Value>(std::move(items));
+        return val;
+    }
+
+    std::string ToString() const {
+        if (type == ValueType::String)
+            return *str_val;
+        if (type == ValueType::Float)
+            return std::to_string(float_val);
+        if (type == ValueType::Bool)
+            return bool_val ? "true" : "false";
+        if (type == ValueType::Int)
+            return std::to_string(int_val);
+        if (type == ValueType::List)
+        {
+            std::string str = "[";
+            for (size_t i = 0; i < list_val->size(); i++)
+            {
+                if (i != 0)
+                    str += ", ";
+                str += (*list_val)[i].ToString();
+            }
+            return str + "]";
+        }
+        return "ref " + std::to_string(reference);
+    }
+
+    float ToFloat() const {
         if (type == ValueType::Float)
             return float_val;
         if (type == ValueType::Bool)
@@ -113,7 +135,7 @@ public:
             return int_val;
     }
 
-    bool ToBool() {
+    bool ToBool() const {
         if (type == ValueType::Float)
             return bool(float_val);
         if (type == ValueType::Bool)
@@ -122,7 +144,7 @@ public:
             return int_val;
     }
 
-    int ToInt() {
+    int ToInt() const {
         if (type == ValueType::Float)
             return int(float_val);
         if (type == ValueType::Bool)
@@ -131,15 +153,15 @@ public:
             return int_val;
     }
 
-    bool IsNumeric() {
+    bool IsNumeric() const {
         return type == ValueType::Int || type == ValueType::Bool || type == ValueType::Float;
     }
 
-    bool IsInteger() {
+    bool IsInteger() const {
         return type == ValueType::Int || type == ValueType::Bool;
     }
 
-    bool operator==(Value& val) {
+    bool operator==(const Value& val) const {
         //if (!IsNumeric() && !val.IsNumeric())
         //    return type == val.type && str_val == val.str_val;
         //if (IsNumeric() && val.IsNumeric())
@@ -147,4 +169,29 @@ public:
         //return false;
         return type == val.type && int_val == val.int_val && str_val == val.str_val;
     }
-};
\ No newline at end of file
+
+private:
+    void release() {
+        if (type == ValueType::String)
+            delete str_val;
+        else if (type == ValueType::List)
+            delete list_val;
+    }
+
+    void copyFrom(const Value& other) {
+        if (type == ValueType::String)
+            str_val = new std::string(*other.str_val);
+        else if (type == ValueType::List)
+            list_val = new std::vector<Value>(*other.list_val);
+        else
+            copy = other.copy;
+    }
+};
+
+inline std::ostream& operator<<(std::ostream& out, const Value& value) {
+    if (value.IsNumeric())
+        return out << value.ToFloat();
+    return out << value.ToString();
+}
+
+static_assert(sizeof(Value) == 16, "Value must stay a 16-byte inline value");
\ No newline at end of file